@@ -9,6 +9,7 @@
 #include <stdexcept>
 #include <sstream>
 #include <memory>
+#include <vector>
 
 #include "type_traits.hh"
 
@@ -247,6 +248,179 @@ public:
 
 };
 
+// Transform Axis ===================================================
+
+/*
+ * Bins uniform in f(x), for a monotonically increasing f
+ * Transform provides f and its inverse:
+ *   edge_type fwd(edge_type x) const;
+ *   edge_type inv(edge_type y) const;
+ * Edges are inv of uniform edges in f, and find_bin is O(1):
+ * the bin is computed from f(x) and then checked against the edges,
+ * so that find_bin always agrees with edge().
+ */
+
+template <typename EdgeType, typename Transform, bool Inherit=false>
+class transform_axis final: public std::conditional_t<Inherit,
+  abstract_axis<EdgeType>, axis_base>
+{
+public:
+  using base_type = std::conditional_t<Inherit,
+    abstract_axis<EdgeType>, axis_base>;
+  using edge_type = EdgeType;
+  using edge_cref = const_ref_if_not_scalar_t<edge_type>;
+  using size_type = ivanp::axis_size_type;
+  using transform_type = Transform;
+
+private:
+  size_type _nbins;
+  edge_type _min, _max, _fmin, _fmax;
+  transform_type _f;
+
+public:
+  transform_axis() = default;
+  ~transform_axis() = default;
+  transform_axis(size_type nbins, edge_cref min, edge_cref max,
+                 transform_type f = { })
+  : _nbins(nbins), _min(std::min(min,max)), _max(std::max(min,max)),
+    _fmin(f.fwd(_min)), _fmax(f.fwd(_max)), _f(f) { }
+
+  inline size_type nbins () const noexcept { return _nbins; }
+  inline size_type nedges() const noexcept { return _nbins+1; }
+
+  inline edge_cref edge(size_type i) const noexcept {
+    if (i==0) return _min;
+    if (i==_nbins) return _max;
+    return _f.inv(_fmin + i*(_fmax - _fmin)/_nbins);
+  }
+
+  inline edge_cref min() const noexcept { return _min; }
+  inline edge_cref max() const noexcept { return _max; }
+
+  inline edge_cref lower(size_type bin) const noexcept { return edge(bin-1); }
+  inline edge_cref upper(size_type bin) const noexcept { return edge(bin); }
+
+  template <typename T>
+  size_type find_bin(const T& x) const noexcept {
+    if (x < _min) return 0;
+    if (!(x < _max)) return _nbins+1;
+    size_type bin = _nbins*(_f.fwd(x)-_fmin)/(_fmax-_fmin) + 1;
+    if (bin > _nbins) bin = _nbins;
+    // correct for rounding
+    if (x < edge(bin-1)) --bin;
+    else if (!(x < edge(bin))) ++bin;
+    return bin;
+  }
+
+  inline size_type vfind_bin(edge_cref x) const noexcept
+  { return find_bin(x); }
+
+  template <typename T>
+  inline size_type operator[](const T& x) const noexcept
+  { return find_bin(x); }
+
+  inline const transform_type& transform() const noexcept { return _f; }
+};
+
+// uniform in log(x), for min > 0
+template <typename EdgeType>
+struct log_transform {
+  inline EdgeType fwd(EdgeType x) const noexcept { return std::log(x); }
+  inline EdgeType inv(EdgeType y) const noexcept { return std::exp(y); }
+};
+
+// uniform in x^p, for p > 0 and min >= 0
+// p < 1 gives finer bins at low x, e.g. p = 0.5 for sqrt
+template <typename EdgeType>
+struct pow_transform {
+  EdgeType p;
+  inline EdgeType fwd(EdgeType x) const noexcept { return std::pow(x,p); }
+  inline EdgeType inv(EdgeType y) const noexcept { return std::pow(y,1/p); }
+};
+
+template <typename EdgeType, bool Inherit=false>
+using log_axis = transform_axis<EdgeType,log_transform<EdgeType>,Inherit>;
+
+template <typename EdgeType, bool Inherit=false>
+using pow_axis = transform_axis<EdgeType,pow_transform<EdgeType>,Inherit>;
+
+// Piecewise Uniform Axis ===========================================
+
+/*
+ * Consecutive uniform segments
+ * Segment k spans [bounds[k],bounds[k+1]) with nbins[k] bins.
+ * find_bin finds the segment among the few boundaries,
+ * and then the bin arithmetically.
+ */
+
+template <typename EdgeType, bool Inherit=false>
+class piecewise_axis final: public std::conditional_t<Inherit,
+  abstract_axis<EdgeType>, axis_base>
+{
+public:
+  using base_type = std::conditional_t<Inherit,
+    abstract_axis<EdgeType>, axis_base>;
+  using edge_type = EdgeType;
+  using edge_cref = const_ref_if_not_scalar_t<edge_type>;
+  using size_type = ivanp::axis_size_type;
+
+private:
+  std::vector<edge_type> _bounds; // segment boundaries
+  std::vector<size_type> _first; // first edge index of each segment
+
+public:
+  piecewise_axis() = default;
+  ~piecewise_axis() = default;
+  // nbins.size() must be bounds.size()-1
+  piecewise_axis(std::vector<edge_type> bounds,
+                 const std::vector<size_type>& nbins)
+  : _bounds(std::move(bounds)), _first(nbins.size()+1,0) {
+    for (size_type k=0; k<nbins.size(); ++k)
+      _first[k+1] = _first[k] + nbins[k];
+  }
+
+  inline size_type nbins () const noexcept { return _first.back(); }
+  inline size_type nedges() const noexcept { return _first.back()+1; }
+
+  edge_cref edge(size_type i) const noexcept {
+    const size_type k = std::distance(_first.begin(),
+      std::upper_bound(_first.begin(),_first.end()-1,i)) - 1;
+    const size_type n = _first[k+1] - _first[k], j = i - _first[k];
+    if (j==0) return _bounds[k];
+    if (j==n) return _bounds[k+1];
+    return _bounds[k] + j*(_bounds[k+1] - _bounds[k])/n;
+  }
+
+  inline edge_cref min() const noexcept { return _bounds.front(); }
+  inline edge_cref max() const noexcept { return _bounds.back(); }
+
+  inline edge_cref lower(size_type bin) const noexcept { return edge(bin-1); }
+  inline edge_cref upper(size_type bin) const noexcept { return edge(bin); }
+
+  template <typename T>
+  size_type find_bin(const T& x) const noexcept {
+    if (x < _bounds.front()) return 0;
+    if (!(x < _bounds.back())) return nbins()+1;
+    const size_type k = std::distance(_bounds.begin(),
+      std::upper_bound(_bounds.begin(),_bounds.end(),x)) - 1;
+    const size_type n = _first[k+1] - _first[k];
+    size_type bin = _first[k]
+      + size_type(n*(x-_bounds[k])/(_bounds[k+1]-_bounds[k])) + 1;
+    if (bin > _first[k+1]) bin = _first[k+1];
+    // correct for rounding
+    if (x < edge(bin-1)) --bin;
+    else if (!(x < edge(bin))) ++bin;
+    return bin;
+  }
+
+  inline size_type vfind_bin(edge_cref x) const noexcept
+  { return find_bin(x); }
+
+  template <typename T>
+  inline size_type operator[](const T& x) const noexcept
+  { return find_bin(x); }
+};
+
 // Index Axis =======================================================
 
 template <typename EdgeType = ivanp::axis_size_type, bool Inherit=false>
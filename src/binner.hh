@@ -156,7 +156,7 @@ public:
   ~binner() = default;
 
   template <typename C=container_type,
-            std::enable_if_t<is_std_vector<C>::value>* = nullptr>
+            std::enable_if_t<!is_std_array<C>::value>* = nullptr>
   binner(typename Ax::axis... axes)
   : _axes{std::forward<typename Ax::axis>(axes)...}, _bins(nbins_total()) { }
   template <typename C=container_type,
@@ -165,7 +165,7 @@ public:
   : _axes{std::forward<typename Ax::axis>(axes)...}, _bins{} { }
 
   template <typename Name, typename C=container_type,
-            std::enable_if_t<is_std_vector<C>::value>* = nullptr>
+            std::enable_if_t<!is_std_array<C>::value>* = nullptr>
   binner(Name&& name, typename Ax::axis... axes)
   : _axes{std::forward<typename Ax::axis>(axes)...}, _bins(nbins_total()) {
     all.emplace_back(this,std::forward<Name>(name));
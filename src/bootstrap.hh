@@ -0,0 +1,64 @@
+#ifndef IVANP_BOOTSTRAP_HH
+#define IVANP_BOOTSTRAP_HH
+
+#include <cstdint>
+#include <cmath>
+#include <limits>
+
+namespace ivanp {
+
+// Poisson(1) weights for bootstrap replicas
+// Weights come from a counter-based generator: the weight of replica k
+// of an event is a hash of the event's key and k, so it does not depend
+// on the order in which events are read or on how they are split
+// between threads, and reruns give the same replicas.
+// The hash is the splitmix64 output function.
+
+class poisson_bootstrap {
+  static constexpr unsigned kmax = 12; // P(X > 12) < 1e-10
+  uint64_t cdf[kmax]; // 2^64 P(X <= k)
+
+public:
+  poisson_bootstrap() {
+    double p = std::exp(-1.), c = 0.;
+    for (unsigned k=0; k<kmax; ++k) {
+      c += p;
+      p /= k+1;
+      cdf[k] = c < 1. ? uint64_t(std::ldexp(c,64))
+                      : std::numeric_limits<uint64_t>::max();
+    }
+  }
+
+  static inline uint64_t mix(uint64_t z) noexcept {
+    z = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9ull;
+    z = (z ^ (z >> 27)) * 0x94d049bb133111ebull;
+    return z ^ (z >> 31);
+  }
+
+  // key of a data event from its run and event numbers
+  static inline uint64_t key(uint64_t run, uint64_t event) noexcept {
+    return mix(mix(run) ^ event);
+  }
+  // key of an MC event, which also needs the sample's channel number,
+  // because samples share run numbers and restart event numbers
+  static inline uint64_t key(
+    uint64_t channel, uint64_t run, uint64_t event
+  ) noexcept {
+    return mix(mix(mix(channel) ^ run) ^ event);
+  }
+
+  // weights of replicas 0 to n-1 of the event with key
+  template <typename T>
+  void operator()(uint64_t key, unsigned n, T* w) const noexcept {
+    for (unsigned k=0; k<n; ++k) {
+      const uint64_t u = mix(key + (k+1)*0x9e3779b97f4a7c15ull);
+      unsigned x = 0;
+      for (unsigned j=0; j<kmax; ++j) x += (u >= cdf[j]);
+      w[k] = x;
+    }
+  }
+};
+
+} // end namespace ivanp
+
+#endif
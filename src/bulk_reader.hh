@@ -0,0 +1,143 @@
+#ifndef IVANP_BULK_READER_HH
+#define IVANP_BULK_READER_HH
+
+#include <vector>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <new>
+#include <type_traits>
+
+#include <TTree.h>
+#include <TBranch.h>
+#include <TBufferFile.h>
+#include <TMath.h>
+
+#include "exception.hh"
+
+namespace ivanp {
+
+// Aligned allocator ================================================
+
+template <typename T, size_t Align=64>
+struct aligned_allocator {
+  using value_type = T;
+  template <typename U>
+  struct rebind { using other = aligned_allocator<U,Align>; };
+
+  aligned_allocator() noexcept = default;
+  template <typename U>
+  aligned_allocator(const aligned_allocator<U,Align>&) noexcept { }
+
+  T* allocate(size_t n) {
+    void *p = nullptr;
+    if (posix_memalign(&p, Align, n*sizeof(T))) throw std::bad_alloc();
+    return static_cast<T*>(p);
+  }
+  void deallocate(T* p, size_t) noexcept { std::free(p); }
+
+  template <typename U>
+  bool operator==(const aligned_allocator<U,Align>&) const noexcept
+  { return true; }
+  template <typename U>
+  bool operator!=(const aligned_allocator<U,Align>&) const noexcept
+  { return false; }
+};
+
+template <typename T>
+using aligned_vector = std::vector<T,aligned_allocator<T>>;
+
+// Byte order =======================================================
+
+namespace detail { namespace bulk {
+
+template <size_t N> struct uint_of_size;
+template <> struct uint_of_size<1> { using type = uint8_t;  };
+template <> struct uint_of_size<2> { using type = uint16_t; };
+template <> struct uint_of_size<4> { using type = uint32_t; };
+template <> struct uint_of_size<8> { using type = uint64_t; };
+
+inline uint8_t  bswap(uint8_t  x) noexcept { return x; }
+inline uint16_t bswap(uint16_t x) noexcept { return __builtin_bswap16(x); }
+inline uint32_t bswap(uint32_t x) noexcept { return __builtin_bswap32(x); }
+inline uint64_t bswap(uint64_t x) noexcept { return __builtin_bswap64(x); }
+
+}} // end namespace detail
+
+// ROOT serializes baskets in big-endian order
+// the swap loop is turned into vector shuffles by gcc -O3
+// if SSSE3 or newer is enabled (e.g. -march=native)
+template <typename T>
+inline void from_big_endian(
+  T* __restrict out, const char* __restrict in, size_t n
+) noexcept {
+  std::memcpy(out, in, n*sizeof(T));
+#if __BYTE_ORDER__ != __ORDER_BIG_ENDIAN__
+  using U = typename detail::bulk::uint_of_size<sizeof(T)>::type;
+  U* __restrict o = reinterpret_cast<U*>(out);
+  for (size_t i=0; i<n; ++i) o[i] = detail::bulk::bswap(o[i]);
+#endif
+}
+
+// Bulk Branch ======================================================
+
+/*
+ * Reads a flat scalar branch one basket at a time
+ * via TBranch::GetBulkRead() (ROOT >= 6.14)
+ * Values of the currently loaded basket are kept
+ * in an aligned native-endian array
+ */
+
+template <typename T>
+class bulk_branch {
+  static_assert(std::is_arithmetic<T>::value,
+    "bulk_branch can only read flat arithmetic branches");
+
+  TBranch *_br;
+  TBufferFile _buf;
+  aligned_vector<T> _vals;
+  Long64_t _first, _last; // loaded entries [first,last)
+
+public:
+  bulk_branch(TTree* tree, const char* name)
+  : _br(tree->GetBranch(name)), _buf(TBuffer::kWrite, 32*1024),
+    _first(0), _last(0)
+  {
+    if (!_br) throw ivanp::exception("no branch ",name);
+  }
+  bulk_branch(const bulk_branch&) = delete;
+  bulk_branch& operator=(const bulk_branch&) = delete;
+
+  // deserialize the basket containing entry ent
+  // returns one past the last loaded entry
+  Long64_t load(Long64_t ent) {
+    if (_first <= ent && ent < _last) return _last;
+
+    const Long64_t first = _br->GetBasketEntry()[ TMath::BinarySearch(
+      Long64_t(_br->GetWriteBasket()+1), _br->GetBasketEntry(), ent) ];
+
+    const Int_t n = _br->GetBulkRead().GetEntriesSerialized(first,_buf);
+    if (n <= 0) throw ivanp::exception(
+      "bulk read failed for branch ",_br->GetName()," at entry ",ent);
+
+    _vals.resize(n);
+    from_big_endian(_vals.data(), _buf.GetCurrent(), n);
+    _first = first;
+    _last  = first + n;
+    return _last;
+  }
+
+  inline const T* data(Long64_t ent) const noexcept {
+    // NOT safe for entries that have not been loaded
+    return _vals.data() + (ent - _first);
+  }
+  inline T operator[](Long64_t ent) { load(ent); return *data(ent); }
+
+  inline Long64_t first() const noexcept { return _first; }
+  inline Long64_t last () const noexcept { return _last;  }
+  inline TBranch* branch() const noexcept { return _br; }
+};
+
+} // end namespace ivanp
+
+#endif
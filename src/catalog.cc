@@ -0,0 +1,199 @@
+#include "catalog.hh"
+
+#include <iostream>
+#include <fstream>
+#include <memory>
+#include <regex>
+#include <future>
+#include <atomic>
+#include <thread>
+#include <algorithm>
+#include <cstdio>
+
+#include <unistd.h>
+
+#include <TFile.h>
+#include <TTree.h>
+#include <TKey.h>
+#include <TH1.h>
+#include <TROOT.h>
+
+#include "file_id.hh"
+#include "exception.hh"
+
+namespace {
+
+const char magic[8] = {'S','I','G','N','C','A','T','3'};
+
+template <typename T>
+inline bool read(std::istream& f, T& x) {
+  return bool(f.read(reinterpret_cast<char*>(&x),sizeof(T)));
+}
+template <typename T>
+inline void write(std::ostream& f, const T& x) {
+  f.write(reinterpret_cast<const char*>(&x),sizeof(T));
+}
+inline bool read(std::istream& f, std::string& s) {
+  uint32_t n;
+  if (!read(f,n)) return false;
+  s.assign(n,'\0');
+  return bool(f.read(&s[0],n));
+}
+inline void write(std::ostream& f, const std::string& s) {
+  write(f,uint32_t(s.size()));
+  f.write(s.data(),s.size());
+}
+
+bool read_cache(const std::string& fname, const std::string& key,
+  file_info& info
+) {
+  std::ifstream f(fname, std::ios::binary);
+  if (!f) return false;
+
+  char m[sizeof(magic)];
+  if (!f.read(m,sizeof(m)) || !std::equal(m,m+sizeof(m),magic))
+    return false;
+
+  std::string file_key;
+  if (!read(f,file_key) || file_key!=key) return false;
+
+  uint64_t nclusters;
+  if (!( read(f,info.entries) && read(f,info.n_all) && read(f,info.lumi)
+      && read(f,info.cutflow) && read(f,nclusters) )) return false;
+  info.clusters.resize(nclusters);
+  return bool(f.read(reinterpret_cast<char*>(info.clusters.data()),
+    nclusters*sizeof(Long64_t)));
+}
+
+void write_cache(const std::string& fname, const std::string& key,
+  const file_info& info
+) {
+  // write to a temporary file first, so that concurrent jobs
+  // never see a partially written entry
+  const std::string tmp = fname + ".tmp" + std::to_string(getpid())
+    + '.' + std::to_string(std::hash<std::thread::id>()(
+        std::this_thread::get_id()));
+  {
+    std::ofstream f(tmp, std::ios::binary);
+    if (!f) {
+      std::cerr << "\033[31mcannot write catalog cache\033[0m: "
+                << tmp << std::endl;
+      return;
+    }
+    f.write(magic,sizeof(magic));
+    write(f,key);
+    write(f,info.entries);
+    write(f,info.n_all);
+    write(f,info.lumi);
+    write(f,info.cutflow);
+    write(f,uint64_t(info.clusters.size()));
+    f.write(reinterpret_cast<const char*>(info.clusters.data()),
+      info.clusters.size()*sizeof(Long64_t));
+  }
+  std::rename(tmp.c_str(),fname.c_str());
+}
+
+void scan(file_info& info) {
+  auto file = std::make_unique<TFile>(info.name.c_str(),"read");
+  if (file->IsZombie())
+    throw ivanp::exception("cannot open file ",info.name);
+
+  TTree *tree = nullptr;
+  file->GetObject("CollectionTree",tree);
+  if (!tree) throw ivanp::exception("no CollectionTree in ",info.name);
+
+  info.entries = tree->GetEntries();
+  auto it = tree->GetClusterIterator(0);
+  for (Long64_t ent; (ent = it()) < info.entries; )
+    info.clusters.push_back(ent);
+
+  if (info.is_mc) {
+    TIter next(file->GetListOfKeys());
+    TKey *key;
+    while ((key = static_cast<TKey*>(next()))) {
+      std::string name(key->GetName());
+      if (name.substr(0,8)!="CutFlow_" ||
+          name.substr(name.size()-18)!="_noDalitz_weighted") continue;
+      std::unique_ptr<TH1> h(static_cast<TH1*>(key->ReadObj()));
+      info.cutflow = std::move(name);
+      info.n_all = h->GetBinContent(3);
+      break;
+    }
+    if (info.cutflow.empty()) throw ivanp::exception(
+      "no CutFlow_*_noDalitz_weighted histogram in ",info.name);
+  }
+
+  file->Close();
+}
+
+} // end anonymous namespace
+
+std::vector<file_info> make_catalog(
+  const std::vector<std::pair<std::string,bool>>& inputs,
+  unsigned nthreads
+) {
+  static const std::regex data_re(
+    "^(.*/)?data.*_(\\d*)ipb.*\\.root$", std::regex::optimize);
+
+  const size_t n = inputs.size();
+  std::vector<file_info> catalog(n);
+  std::vector<char> from_cache(n,false);
+
+  for (size_t i=0; i<n; ++i) {
+    auto& info = catalog[i];
+    info.name  = inputs[i].first;
+    info.is_mc = inputs[i].second;
+    info.entries = 0;
+    info.n_all = 0;
+    info.lumi  = 0;
+    std::smatch match;
+    if (!info.is_mc && std::regex_search(info.name,match,data_re))
+      info.lumi = std::stod(match[2]);
+  }
+
+  // scan files in parallel
+  if (!nthreads) nthreads = std::max(1u,std::thread::hardware_concurrency());
+  nthreads = std::min<size_t>(nthreads,n);
+  ROOT::EnableThreadSafety();
+
+  const std::string dir = ivanp::cache_dir();
+  std::atomic<size_t> next(0);
+  std::vector<std::future<void>> workers;
+  for (unsigned t=0; t<nthreads; ++t)
+    workers.emplace_back(std::async(std::launch::async,[&]{
+      for (size_t i; (i = next++) < n; ) {
+        auto& info = catalog[i];
+        const ivanp::file_id id(info.name);
+        info.size = id.size;
+        const std::string key = ivanp::cat(id.str(),'|',info.is_mc);
+        const std::string fname = dir+"/"+id.hash(key)+".catalog";
+        if (read_cache(fname,key,info)) { from_cache[i] = true; continue; }
+        info.clusters.clear();
+        scan(info);
+        write_cache(fname,key,info);
+      }
+    }));
+  for (auto& w : workers) w.get(); // rethrows
+
+  const auto ncached = std::count(from_cache.begin(),from_cache.end(),true);
+  std::cout << "\033[36mCatalog\033[0m: " << n << " files, "
+            << ncached << " from cache" << std::endl;
+  return catalog;
+}
+
+long long cluster_bytes(const file_info& info) {
+  if (info.entries <= 0 || info.clusters.empty()) return 0;
+  Long64_t max = 0;
+  for (size_t i=0; i<info.clusters.size(); ++i) {
+    const Long64_t end = i+1 < info.clusters.size()
+      ? info.clusters[i+1] : info.entries;
+    max = std::max(max,end-info.clusters[i]);
+  }
+  return info.size * (double(max)/info.entries);
+}
+
+double data_lumi(const std::vector<file_info>& catalog) {
+  double lumi = 0.;
+  for (const auto& f : catalog) if (!f.is_mc) lumi += f.lumi;
+  return lumi;
+}
@@ -0,0 +1,43 @@
+#ifndef IVANP_CATALOG_HH
+#define IVANP_CATALOG_HH
+
+#include <string>
+#include <vector>
+#include <utility>
+
+#include <Rtypes.h>
+
+/*
+ * Input catalog
+ *
+ * Metadata of every input file is collected once, opening all inputs
+ * in parallel, and cached on disk in $SIGNIF_CACHE (default .cache/),
+ * keyed by the file path, size and modification time.
+ * Reruns read only the cache and do not open the files before
+ * their events are processed.
+ */
+
+struct file_info {
+  std::string name;
+  bool is_mc;
+  long long size;  // bytes on disk
+  Long64_t entries; // in CollectionTree
+  std::vector<Long64_t> clusters; // first entry of each cluster
+  std::string cutflow; // name of the CutFlow_*_noDalitz_weighted histogram
+  double n_all; // MC: sum of weights of all generated events
+  double lumi;  // data: ipb from the file name
+};
+
+// inputs are pairs of file name and is_mc
+std::vector<file_info> make_catalog(
+  const std::vector<std::pair<std::string,bool>>& inputs,
+  unsigned nthreads = 0);
+
+// bytes on disk of the largest cluster, estimated from the file size
+// used to size the TTreeCache, which reads one cluster at a time
+long long cluster_bytes(const file_info& info);
+
+// total luminosity of the data files, ipb
+double data_lumi(const std::vector<file_info>& catalog);
+
+#endif
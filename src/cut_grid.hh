@@ -0,0 +1,125 @@
+#ifndef CUT_GRID_HH
+#define CUT_GRID_HH
+
+// Cumulative 3D grid for scanning selections of the form
+//   x > a && y > b && z < c
+// such as the VBF cuts on m_jj, Dy_jj and pT_j3
+// Requires signif_hist.hh to be included first
+
+#include <vector>
+#include <array>
+#include <algorithm>
+#include <cmath>
+
+#include "axis.hh"
+
+class cut_grid {
+public:
+  using axis_type = ivanp::uniform_axis<double>;
+
+private:
+  std::array<axis_type,3> axes;
+  std::array<unsigned,3> n; // bins per axis, with under- and overflow
+  // signal is kept per process only if processes are reweighted
+  // or printed
+  unsigned nproc;
+  // bkg, bkg2, then sig, sig2, reco, truth of each process
+  unsigned stride;
+  std::vector<double> cells;
+  bool cumulative = false;
+
+  inline unsigned index(unsigned i, unsigned j, unsigned k) const noexcept {
+    return ((i*n[1] + j)*n[2] + k)*stride;
+  }
+  inline double* cell(double x, double y, double z) {
+    return cells.data() + index(
+      axes[0].find_bin(x), axes[1].find_bin(y), axes[2].find_bin(z));
+  }
+
+public:
+  cut_grid(const axis_type& x, const axis_type& y, const axis_type& z)
+  : axes{x,y,z}, n{x.nbins()+2, y.nbins()+2, z.nbins()+2},
+    nproc(proc_reweighted() || hist_bin::print_procs ? n_proc : 1), stride(2+4*nproc),
+    cells(n[0]*n[1]*n[2]*stride, 0.) { }
+
+  inline const axis_type& axis(unsigned i) const noexcept { return axes[i]; }
+
+  // Fills with hist_bin::weight, following hist_bin::operator()
+  // An event passes a selection both at reco and truth level iff
+  // the weakest of its values passes, so truth is filled at
+  // min(det,truth) for x and y, and max(det,truth) for z
+  template <typename T1, typename T2, typename T3>
+  void operator()(const var<T1>& x, const var<T2>& y, const var<T3>& z,
+    bool truth_match=true
+  ) {
+    const double w = hist_bin::weight;
+    double* c = cell(x.det,y.det,z.det);
+    if (is_mc) {
+      const unsigned p = 2 + 4*(nproc>1 ? hist_bin::proc : 0);
+      if (is_in_window) {
+        c[p] += w;
+        c[p+1] += w*w;
+      }
+      c[p+2] += w;
+      if (is_fiducial && truth_match)
+        cell(std::min<double>(x.det,x.truth),
+             std::min<double>(y.det,y.truth),
+             std::max<double>(z.det,z.truth))[p+3] += w;
+    } else {
+      c[0] += w;
+      c[1] += w*w;
+    }
+  }
+
+  // Turns cells into sums over all bins at or above i and j,
+  // and at or below k, after which operator() must not be called
+  void accumulate() {
+    if (cumulative) return;
+    for (unsigned i=n[0]-1; i--; )
+      for (unsigned j=0; j<n[1]; ++j)
+        for (unsigned k=0; k<n[2]; ++k)
+          add(index(i,j,k),index(i+1,j,k));
+    for (unsigned i=0; i<n[0]; ++i)
+      for (unsigned j=n[1]-1; j--; )
+        for (unsigned k=0; k<n[2]; ++k)
+          add(index(i,j,k),index(i,j+1,k));
+    for (unsigned i=0; i<n[0]; ++i)
+      for (unsigned j=0; j<n[1]; ++j)
+        for (unsigned k=1; k<n[2]; ++k)
+          add(index(i,j,k),index(i,j,k-1));
+    cumulative = true;
+  }
+
+  // Edge index of an axis nearest to a cut value
+  unsigned edge(unsigned a, double cut) const noexcept {
+    const auto& ax = axes[a];
+    const double i = (cut-ax.min())/(ax.max()-ax.min())*ax.nbins();
+    return std::min<double>(std::max(std::round(i),0.),ax.nbins());
+  }
+
+  // Events with x >= edge ex, y >= edge ey, and z < edge ez
+  // Requires accumulate() to have been called
+  hist_bin operator()(unsigned ex, unsigned ey, unsigned ez) const noexcept {
+    const double* c = cells.data() + index(ex+1,ey+1,ez);
+    hist_bin b;
+    b.bkg  = c[0];
+    b.bkg2 = c[1];
+    for (unsigned i=0; i<nproc; ++i) {
+      const double* p = c + 2 + 4*i;
+      b.sig   += p[0];
+      b.sig2  += p[1];
+      b.reco  += p[2];
+      b.truth += p[3];
+      // for reweighting and fractions of processes when printing
+      if (nproc>1) std::copy(p,p+4,b.procs[i].begin());
+    }
+    return b;
+  }
+
+private:
+  inline void add(unsigned a, unsigned b) noexcept {
+    for (unsigned l=0; l<stride; ++l) cells[a+l] += cells[b+l];
+  }
+};
+
+#endif
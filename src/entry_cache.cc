@@ -0,0 +1,158 @@
+#include "entry_cache.hh"
+
+#include <iostream>
+#include <iomanip>
+#include <fstream>
+#include <string>
+#include <algorithm>
+#include <limits>
+#include <cstdio>
+#include <cstdlib>
+
+#include <unistd.h>
+
+#include <TTree.h>
+
+#include "bulk_reader.hh"
+#include "file_id.hh"
+#include "array_ops.hh"
+#include "exception.hh"
+
+namespace {
+
+const char magic[8] = {'S','I','G','N','E','L','S','T'};
+
+bool read_cache(const std::string& fname, const std::string& key,
+  std::vector<Long64_t>& entries
+) {
+  std::ifstream f(fname, std::ios::binary);
+  if (!f) return false;
+
+  char m[sizeof(magic)];
+  if (!f.read(m,sizeof(m)) || !std::equal(m,m+sizeof(m),magic))
+    return false;
+
+  uint32_t key_len;
+  if (!f.read(reinterpret_cast<char*>(&key_len),sizeof(key_len)))
+    return false;
+  std::string file_key(key_len,'\0');
+  if (!f.read(&file_key[0],key_len) || file_key!=key) return false;
+
+  uint64_t n;
+  if (!f.read(reinterpret_cast<char*>(&n),sizeof(n))) return false;
+  entries.resize(n);
+  return bool(f.read(
+    reinterpret_cast<char*>(entries.data()), n*sizeof(Long64_t)));
+}
+
+void write_cache(const std::string& fname, const std::string& key,
+  const std::vector<Long64_t>& entries
+) {
+  // write to a temporary file first, so that concurrent jobs
+  // never see a partially written list
+  const std::string tmp = fname + ".tmp" + std::to_string(getpid());
+  {
+    std::ofstream f(tmp, std::ios::binary);
+    if (!f) {
+      std::cerr << "\033[31mcannot write entry list cache\033[0m: "
+                << tmp << std::endl;
+      return;
+    }
+    const uint32_t key_len = key.size();
+    const uint64_t n = entries.size();
+    f.write(magic,sizeof(magic));
+    f.write(reinterpret_cast<const char*>(&key_len),sizeof(key_len));
+    f.write(key.data(),key_len);
+    f.write(reinterpret_cast<const char*>(&n),sizeof(n));
+    f.write(reinterpret_cast<const char*>(entries.data()),
+      n*sizeof(Long64_t));
+  }
+  std::rename(tmp.c_str(),fname.c_str());
+}
+
+} // end anonymous namespace
+
+namespace {
+
+// file is opened only if the list is not cached
+std::vector<Long64_t> selected_entries_impl(
+  const char* file_name, TFile* file, const char* tree_name,
+  const std::array<double,2>& myy_range
+) {
+  const ivanp::file_id id(file_name);
+  // the range is written with all significant digits, so that
+  // ranges that differ only in the last digits get different keys
+  const std::string key = ivanp::cat(
+    id.str(),'|',tree_name,'|',
+    std::setprecision(std::numeric_limits<double>::max_digits10),
+    myy_range[0],'|',myy_range[1]);
+  const std::string fname = ivanp::cache_dir()+"/"+id.hash(key)+".entries";
+
+  std::vector<Long64_t> entries;
+  if (read_cache(fname,key,entries)) {
+    std::cout << "Entry list from cache: " << fname
+              << " (" << entries.size() << " entries)" << std::endl;
+    return entries;
+  }
+  entries.clear();
+
+  std::unique_ptr<TFile> opened;
+  if (!file) {
+    opened.reset(new TFile(file_name,"read"));
+    if (opened->IsZombie())
+      throw ivanp::exception("cannot open file ",file_name);
+    file = opened.get();
+  }
+
+  // phase one: read only the selection branches
+  TTree *tree = nullptr;
+  file->GetObject(tree_name,tree);
+  if (!tree) throw ivanp::exception("no ",tree_name," in ",file->GetName());
+
+  ivanp::bulk_branch<Char_t> _isPassed(tree,"HGamEventInfoAuxDyn.isPassed");
+  ivanp::bulk_branch<Float_t> _m_yy(tree,"HGamEventInfoAuxDyn.m_yy");
+
+  const Long64_t nent = tree->GetEntries();
+  for (Long64_t ent=0; ent<nent; ) {
+    const Long64_t end = std::min(_isPassed.load(ent), _m_yy.load(ent));
+    const Char_t  *isPassed = _isPassed.data(ent);
+    const Float_t *m_yy = _m_yy.data(ent);
+    for (Long64_t i=0, n=end-ent; i<n; ++i)
+      if (isPassed[i] && in(m_yy[i],myy_range)) entries.push_back(ent+i);
+    ent = end;
+  }
+  std::cout << "Selected " << entries.size() << " of " << nent
+            << " entries" << std::endl;
+
+  write_cache(fname,key,entries);
+  return entries;
+}
+
+} // end anonymous namespace
+
+std::vector<Long64_t> selected_entries(
+  TFile* file, const char* tree_name,
+  const std::array<double,2>& myy_range
+) {
+  return selected_entries_impl(file->GetName(),file,tree_name,myy_range);
+}
+
+std::vector<Long64_t> selected_entries(
+  const char* file_name, const char* tree_name,
+  const std::array<double,2>& myy_range
+) {
+  return selected_entries_impl(file_name,nullptr,tree_name,myy_range);
+}
+
+std::unique_ptr<TEntryList> make_entry_list(
+  TFile* file, const char* tree_name,
+  const std::array<double,2>& myy_range
+) {
+  const auto entries = selected_entries(file,tree_name,myy_range);
+  TTree *tree = nullptr;
+  file->GetObject(tree_name,tree);
+  std::unique_ptr<TEntryList> elist(new TEntryList(tree));
+  elist->SetDirectory(nullptr); // owned here, not by the file
+  for (const auto ent : entries) elist->Enter(ent);
+  return elist;
+}
@@ -0,0 +1,37 @@
+#ifndef IVANP_ENTRY_CACHE_HH
+#define IVANP_ENTRY_CACHE_HH
+
+#include <vector>
+#include <array>
+#include <memory>
+
+#include <TFile.h>
+#include <TEntryList.h>
+
+/*
+ * Two-phase event selection
+ *
+ * Phase one reads only isPassed and m_yy and collects entries
+ * with isPassed and m_yy within myy_range.
+ * The resulting entry list is cached on disk in $SIGNIF_CACHE
+ * (default .cache/), keyed by the file path, size and modification
+ * time, the tree name and the cut values.
+ * Phase two iterates only over the listed entries, so baskets
+ * without surviving events are never read for the other branches.
+ */
+
+std::vector<Long64_t> selected_entries(
+  TFile* file, const char* tree_name,
+  const std::array<double,2>& myy_range);
+
+// opens the file only if the list is not cached
+std::vector<Long64_t> selected_entries(
+  const char* file_name, const char* tree_name,
+  const std::array<double,2>& myy_range);
+
+// TTreeReader can iterate over a TEntryList directly
+std::unique_ptr<TEntryList> make_entry_list(
+  TFile* file, const char* tree_name,
+  const std::array<double,2>& myy_range);
+
+#endif
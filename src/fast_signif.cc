@@ -0,0 +1,233 @@
+#include <iostream>
+#include <iomanip>
+#include <vector>
+#include <array>
+#include <string>
+#include <cstring>
+#include <regex>
+
+#include "binner.hh"
+#include "re_axes.hh"
+#include "timed_counter.hh"
+#include "array_ops.hh"
+#include "exception.hh"
+#include "skim_file.hh"
+
+// ROOT-free version of signif, reading memory-mapped skim files
+// written by the skim program
+
+using std::cout;
+using std::cerr;
+using std::endl;
+
+// global variables =================================================
+bool is_mc, is_fiducial, is_in_window;
+// ==================================================================
+#include "truth_reco_var.hh"
+
+#include "signif_hist.hh"
+#include "signif_fill.hh"
+
+// det and truth columns of a skimmed variable
+template <typename T=double>
+class column {
+  const float *_det, *_truth;
+public:
+  column(const skim::reader& f, const std::string& name)
+  : _det(f.column<float>(name)), _truth(f.column<float>(name+".truth")) { }
+  inline var<T> operator()(uint64_t i) const noexcept {
+    return { T(_det[i]), T(_truth[i]) };
+  }
+};
+
+// Jet columns at the current event, with the members of signif's
+// jet_vars, for the shared fill_jets
+// Skims only have the 30 GeV jet variables, without a suffix
+class skim_jets {
+  template <typename T>
+  class entry {
+    column<T> _col;
+    const uint64_t& _i;
+  public:
+    entry(const skim::reader& f, const std::string& name, const uint64_t& i)
+    : _col(f,name), _i(i) { }
+    inline var<T> operator*() const noexcept { return _col(_i); }
+  };
+
+public:
+  entry<int> N_j;
+  entry<double>
+    HT, pT_j1, pT_j2, pT_j3, yAbs_j1, yAbs_j2,
+    Dphi_j_j, Dphi_j_j_signed, Dy_j_j, m_jj,
+    sumTau_yyj, maxTau_yyj, pT_yyjj, Dphi_yy_jj;
+
+#define VARJ_(NAME) NAME(f, #NAME, i)
+  skim_jets(const skim::reader& f, const uint64_t& i)
+  : VARJ_(N_j), VARJ_(HT),
+    VARJ_(pT_j1), VARJ_(pT_j2), VARJ_(pT_j3),
+    VARJ_(yAbs_j1), VARJ_(yAbs_j2),
+    VARJ_(Dphi_j_j), VARJ_(Dphi_j_j_signed),
+    VARJ_(Dy_j_j), VARJ_(m_jj),
+    VARJ_(sumTau_yyj), VARJ_(maxTau_yyj),
+    VARJ_(pT_yyjj), VARJ_(Dphi_yy_jj) { }
+#undef VARJ_
+};
+
+int main(int argc, const char* argv[]) {
+  const std::array<double,2> myy_window{121e3,129e3};
+  std::array<double,2> myy_range{0,0};
+  double lumi = 0., lumi_in = 0.;
+
+  std::vector<skim::reader> skims;
+  skims.reserve(argc-1);
+  std::vector<skim::cut> cuts;
+  const char* bins_file = nullptr;
+
+  for (int a=1; a<argc; ++a) { // loop over arguments
+    static const std::regex skim_re(
+      "^(.*/)?.*\\.skim$", std::regex::optimize);
+    static const std::regex bins_re(
+      "^(.*/)?.*\\.bins$", std::regex::optimize);
+    static const std::regex lumi_re(
+      "([-+]?[0-9]*\\.?[0-9]+([eE][-+]?[0-9]+)?) *i([pf])b$",
+      std::regex::optimize);
+    static const std::regex cut_re(
+      "^cut:(.+)$", std::regex::optimize);
+    std::cmatch match;
+
+    const char *arg = argv[a], *end = arg+std::strlen(arg);
+    if (std::regex_search(arg,end,match,cut_re)) {
+      cout << "\033[36mCut\033[0m: " << match[1] << endl;
+      cuts.emplace_back(match[1]);
+    } else if (std::regex_search(arg,end,match,skim_re)) {
+      skims.emplace_back(arg);
+      const auto& head = skims.back().head();
+      cout << "\033[36mSkim\033[0m: " << arg
+           << " (" << head.nevents << " events)" << endl;
+      if (skims.size()==1) {
+        myy_range = { head.myy_range[0], head.myy_range[1] };
+      } else if (myy_range[0]!=head.myy_range[0] ||
+                 myy_range[1]!=head.myy_range[1]) {
+        cerr << "skim files have different m_yy ranges" << endl;
+        return 1;
+      }
+      lumi_in += head.lumi_in;
+    } else if (std::regex_search(arg,end,match,bins_re)) {
+      cout << "\033[36mBinning\033[0m: " << arg << endl;
+      bins_file = arg;
+    } else if (std::regex_search(arg,end,match,lumi_re)) {
+      lumi = std::stod(match[1]);
+      if (arg[match.position(3)]=='f') lumi *= 1e3; // femto to pico
+    } else {
+      cerr << "arg error: unrecognized argument: " << arg << endl;
+      return 1;
+    }
+  }
+  if (!bins_file) {
+    cerr << "Must specify a .bins file" << endl;
+    return 1;
+  }
+  if (!skims.size()) {
+    cerr << "Must specify at least 1 .skim file" << endl;
+    return 1;
+  }
+  const double data_factor =
+    len(myy_window)/(len(myy_range)-len(myy_window));
+  cout << "\n\033[36mTotal data lumi\033[0m: "
+       << lumi_in << " ipb" << endl;
+  if (lumi==0.) lumi = lumi_in;
+  cout << "Scaling to " << lumi << " ipb" << endl << endl;
+  // accumulate signal per ipb and raw data counts, as in signif
+  hist_bin::sig_scale = lumi;
+  hist_bin::bkg_scale = data_factor * lumi / lumi_in;
+
+  // Histogram definitions ==========================================
+  re_axes ra(bins_file);
+#define h_(name) re_hist<1> h_##name(#name,ra[#name]);
+
+  hist<ivanp::index_axis<int>> h_total("total",{0,1});
+
+  h_(pT_yy) h_(yAbs_yy) h_(cosTS_yy) h_(pTt_yy) h_(Dy_y_y)
+
+  hist2 h_cosTS_pT_yy("cosTS_pT_yy",{0.,0.5,1.},{0.,30.,120.,400.});
+
+  jet_hists h_jets(ra,"");
+
+  for (const auto& f : skims) { // loop over skim files
+    for (auto& cut : cuts) cut.bind(f);
+    const float *_weight = f.column<float>("weight");
+    const uint8_t *_flags = f.column<uint8_t>("flags");
+
+#define VAR_GEN_(NAME, TYPE) const column<TYPE> _##NAME(f, #NAME);
+#define VAR_(NAME) VAR_GEN_(NAME, double)
+
+    VAR_(m_yy) VAR_(pT_yy) VAR_(yAbs_yy) VAR_(cosTS_yy) VAR_(pTt_yy)
+    VAR_(Dy_y_y)
+    VAR_(m_yyj)
+
+    uint64_t i; // current event
+    skim_jets jets(f,i);
+
+    // event at index i
+    const auto fill_event = [&]{
+      if (!std::all_of(cuts.begin(),cuts.end(),
+        [i](const skim::cut& cut){ return cut(i); })) return;
+
+      const uint8_t flags = _flags[i];
+      is_mc = flags & skim::mc_flag;
+
+      is_in_window = in(_m_yy(i).det,myy_window);
+
+      if (is_mc) { // signal from MC
+        hist_bin::weight = _weight[i];
+        is_fiducial = flags & skim::fiducial_flag;
+      } else { // background from data
+        if (is_in_window) return;
+        hist_bin::weight = 1.;
+      }
+
+      // FILL HISTOGRAMS ============================================
+
+      const auto pT_yy = _pT_yy(i)*1e-3;
+      const auto yAbs_yy = _yAbs_yy(i);
+      const auto cosTS_yy = abs(_cosTS_yy(i));
+      const auto Dy_y_y = abs(_Dy_y_y(i));
+
+      h_total(0);
+
+      fill(h_pT_yy, pT_yy);
+      fill(h_yAbs_yy, yAbs_yy);
+      fill(h_cosTS_yy, cosTS_yy);
+
+      fill(h_Dy_y_y, Dy_y_y);
+      fill(h_pTt_yy, _pTt_yy(i)*1e-3);
+      fill(h_cosTS_pT_yy, cosTS_yy, pT_yy);
+
+      fill_jets(jets, h_jets, pT_yy, _m_yyj(i));
+    };
+
+    // LOOP over blocks =============================================
+    uint64_t nblocks_read = 0;
+    using tc = ivanp::timed_counter<uint64_t>;
+    for (tc b(f.nblocks()); b < f.nblocks(); ++b) {
+      // skip blocks that cannot pass the cuts
+      if (!std::all_of(cuts.begin(),cuts.end(),
+        [&b](const skim::cut& cut){ return cut.block(b); })) continue;
+      ++nblocks_read;
+
+      const uint64_t first = uint64_t(b)*f.block_size();
+      const uint64_t last  = std::min(first+f.block_size(),f.nevents());
+
+      // LOOP over events ===========================================
+      for (i=first; i<last; ++i) fill_event();
+    }
+    cout << "Read " << nblocks_read << " of " << f.nblocks()
+         << " blocks" << endl;
+  }
+
+  for (const auto& h : hist<ivanp::index_axis<int>>::all) cout << h << endl;
+  for (const auto& h : re_hist<1>::all) cout << h << endl;
+  for (const auto& h : hist2::all) cout << h << endl;
+
+  return 0;
+}
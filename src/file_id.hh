@@ -0,0 +1,58 @@
+#ifndef IVANP_FILE_ID_HH
+#define IVANP_FILE_ID_HH
+
+#include <string>
+#include <sstream>
+#include <iomanip>
+#include <functional>
+#include <climits>
+#include <cstdlib>
+
+#include <sys/stat.h>
+
+#include "exception.hh"
+
+namespace ivanp {
+
+// identifies the contents of a file on disk by its path, size and
+// modification time, without reading it
+struct file_id {
+  std::string path;
+  long long size, mtime;
+
+  file_id(const std::string& name) {
+    char buf[PATH_MAX];
+    path = realpath(name.c_str(),buf) ? buf : name;
+    struct stat st;
+    if (stat(path.c_str(),&st))
+      throw ivanp::exception("cannot stat file ",name);
+    size  = st.st_size;
+    mtime = st.st_mtime;
+  }
+
+  inline std::string str() const {
+    return cat(path,'|',size,'|',mtime);
+  }
+
+  // hex digest of the id and any extra key parts
+  // used for naming cache files
+  template <typename... Extra>
+  std::string hash(const Extra&... extra) const {
+    std::ostringstream ss;
+    ss << std::hex << std::setfill('0') << std::setw(2*sizeof(size_t))
+       << std::hash<std::string>()(cat(str(),extra...));
+    return ss.str();
+  }
+};
+
+// directory for cache files: $SIGNIF_CACHE or .cache/
+inline std::string cache_dir() {
+  const char* dir = std::getenv("SIGNIF_CACHE");
+  std::string path(dir && *dir ? dir : ".cache");
+  mkdir(path.c_str(),0755); // ok if it already exists
+  return path;
+}
+
+} // end namespace ivanp
+
+#endif
@@ -10,7 +10,6 @@
 #include <TTreeReader.h>
 #include <TTreeReaderValue.h>
 #include <TH1.h>
-#include <TKey.h>
 
 #include "binner.hh"
 #include "re_axes.hh"
@@ -18,6 +17,7 @@
 #include "timed_counter.hh"
 #include "array_ops.hh"
 #include "exception.hh"
+#include "mxaod_pool.hh"
 
 #define test(var) \
   std::cout <<"\033[36m"<< #var <<"\033[0m"<< " = " << var << std::endl;
@@ -33,6 +33,67 @@ double n_all_inv, lumi = 0.;
 // ==================================================================
 #include "truth_reco_var.hh"
 
+// Histograms =======================================================
+
+// filled the same way as TH1D::Fill(x,w), with a binner lookup,
+// and converted to TH1D only once at the end
+struct hist_bin {
+  double w = 0, w2 = 0;
+  inline hist_bin& operator+=(double weight) noexcept {
+    w += weight;
+    w2 += weight*weight;
+    return *this;
+  }
+};
+
+class hist {
+  using axis_type = ivanp::container_axis<std::vector<double>>;
+  ivanp::binner<hist_bin, std::tuple<ivanp::axis_spec<axis_type>>> h;
+  double entries = 0, stats[4] = { }; // sumw, sumw2, sumwx, sumwx2
+  bool weighted = false;
+
+public:
+  const std::string name;
+  static std::vector<hist*> all;
+
+  template <size_t N>
+  hist(const std::string& name, const double(&edges)[N])
+  : h(axis_type(std::vector<double>(edges,edges+N))), name(name) {
+    all.push_back(this);
+  }
+  hist(const hist&) = delete;
+
+  inline void operator()(double x, double weight) {
+    ++entries;
+    if (weight != 1.) weighted = true;
+    const auto bin = h.fill(x,weight);
+    // only in-range values contribute to the statistics
+    if (bin == 0 || bin > h.axis().nbins()) return;
+    stats[0] += weight;
+    stats[1] += weight*weight;
+    stats[2] += weight*x;
+    stats[3] += weight*x*x;
+  }
+
+  // TH1D in the current directory
+  TH1D* th1() const {
+    const auto& edges = h.axis().edges();
+    TH1D *th = new TH1D(name.c_str(),"",edges.size()-1,edges.data());
+    if (weighted) th->Sumw2();
+    const auto& bins = h.bins();
+    for (unsigned i=0; i<bins.size(); ++i) {
+      th->SetBinContent(i,bins[i].w);
+      if (weighted) th->SetBinError(i,std::sqrt(bins[i].w2));
+    }
+    // SetBinContent invalidates these
+    th->SetEntries(entries);
+    double s[4] = { stats[0], stats[1], stats[2], stats[3] };
+    th->PutStats(s);
+    return th;
+  }
+};
+std::vector<hist*> hist::all;
+
 int main(int argc, char* argv[]) {
   if (argc==1) {
     cout << "usage: " << argv[0] << " *.root [?i{pf}b]" << endl;
@@ -40,8 +101,7 @@ int main(int argc, char* argv[]) {
   }
   const std::array<double,2> myy_range{105e3,160e3};
 
-  std::vector<std::unique_ptr<TFile>> mxaods;
-  mxaods.reserve(argc-2);
+  mxaod_pool mxaods;
   bool lumi_arg = false;
   for (int a=1; a<argc; ++a) { // loop over arguments
     // validate args and parse names of input files
@@ -66,8 +126,7 @@ int main(int argc, char* argv[]) {
       const double flumi = std::stod(match[2]);
       lumi += flumi;
       cout << "\033[36mLumi\033[0m: " << flumi << " ipb" << endl;
-      mxaods.emplace_back(new TFile(arg,"read"));
-      if (mxaods.back()->IsZombie()) return 1;
+      mxaods.emplace_back(arg,is_mc);
     } else if (std::regex_search(arg,end,match,mc_re)) { // MC
       cout << "\033[36mMC\033[0m: " << arg << endl;
       if (a==1+lumi_arg) {
@@ -76,8 +135,7 @@ int main(int argc, char* argv[]) {
         cerr << "all input files must be either data or MC" << endl;
         return 1;
       }
-      mxaods.emplace_back(new TFile(arg,"read"));
-      if (mxaods.back()->IsZombie()) return 1;
+      mxaods.emplace_back(arg,is_mc);
     } else if (std::regex_search(arg,end,match,lumi_re)) {
       if (lumi_arg) {
         cerr << "arg error: repeated lumi arg: " << arg << endl;
@@ -100,10 +158,8 @@ int main(int argc, char* argv[]) {
   auto fout = std::make_unique<TFile>("hists.root","recreate");
 
   // Histogram definitions ==========================================
-#define h_(NAME) TH1D *h_##NAME = new \
-  TH1D(#NAME,"",sizeof(b_##NAME)/sizeof(double)-1,b_##NAME);
-#define h_truth_(NAME) TH1D *h_##NAME##_truth = new \
-  TH1D(#NAME"_truth","",sizeof(b_##NAME)/sizeof(double)-1,b_##NAME);
+#define h_(NAME) hist h_##NAME(#NAME,b_##NAME);
+#define h_truth_(NAME) hist h_##NAME##_truth(#NAME"_truth",b_##NAME);
 
   double b_HT[] = { 0,30,75,140,200,500 };
   double b_pT_yy[] = { 0,10,15,20,30,45,60,80,100,120,155,200,260,400 };
@@ -120,9 +176,6 @@ int main(int argc, char* argv[]) {
   h_(pT_yy) h_(pT_j1) h_(pT_j2) h_(pT_j3)
   h_(xH) h_(x1) h_(x2) h_(x3)
 
-  // no truth histograms for data
-  if (!is_mc) TH1::AddDirectory(false);
-
   h_truth_(HT)
   h_truth_(pT_yy) h_truth_(pT_j1) h_truth_(pT_j2) h_truth_(pT_j3)
   h_truth_(xH) h_truth_(x1) h_truth_(x2) h_truth_(x3)
@@ -131,27 +184,18 @@ int main(int argc, char* argv[]) {
   //   nH_truth = 0, n1_truth = 0, n2_truth = 0, n3_truth = 0;
   unsigned n0 = 0, nn0 = 0;
 
-  for (auto& file : mxaods) { // loop over MxAODs
+  while (mxaod file = mxaods.next()) { // loop over MxAODs
     cout << "\033[36mMC\033[0m: " << file->GetName() << endl;
 
     if (is_mc) {
-      TIter next(file->GetListOfKeys());
-      TKey *key;
-      while ((key = static_cast<TKey*>(next()))) {
-        std::string name(key->GetName());
-        if (name.substr(0,8)!="CutFlow_" ||
-            name.substr(name.size()-18)!="_noDalitz_weighted") continue;
-        TH1 *h = static_cast<TH1*>(key->ReadObj());
-        cout << h->GetName() << endl;
-        n_all_inv = h->GetBinContent(3);
-        cout << h->GetXaxis()->GetBinLabel(3) << " = " << n_all_inv << endl;
-        n_all_inv = 1./n_all_inv;
-        break;
-      }
+      const file_info& info = file.info();
+      cout << info.cutflow << endl;
+      cout << "sum of weights = " << info.n_all << endl;
+      n_all_inv = 1./info.n_all;
     }
 
     // read variables ===============================================
-    TTreeReader reader("CollectionTree",file.get());
+    TTreeReader reader("CollectionTree",*file);
     TTreeReaderValue<Char_t> _isPassed(reader,"HGamEventInfoAuxDyn.isPassed");
     optional<TTreeReaderValue<Float_t>> _cs_br_fe, _weight;
     optional<TTreeReaderValue<Char_t>> _isFiducial;
@@ -210,14 +254,14 @@ int main(int argc, char* argv[]) {
         else ++nn0;
       }
 
-      h_HT->Fill(HT.det,weight);
-      h_pT_yy->Fill(pT_yy.det,weight);
-      h_xH->Fill(xH.det,weight);
+      h_HT(HT.det,weight);
+      h_pT_yy(pT_yy.det,weight);
+      h_xH(xH.det,weight);
 
       if (is_fiducial) {
-        h_HT_truth->Fill(HT.truth,weight);
-        h_pT_yy_truth->Fill(pT_yy.truth,weight);
-        h_xH_truth->Fill(xH.truth,weight);
+        h_HT_truth(HT.truth,weight);
+        h_pT_yy_truth(pT_yy.truth,weight);
+        h_xH_truth(xH.truth,weight);
         // if (xH.truth > 1) ++nH_truth;
       }
 
@@ -233,12 +277,12 @@ int main(int argc, char* argv[]) {
       // }
       // if (x1.det > 1) ++n1;
 
-      h_pT_j1->Fill(pT_j1.det,weight);
-      h_x1->Fill(x1.det,weight);
+      h_pT_j1(pT_j1.det,weight);
+      h_x1(x1.det,weight);
 
       if (is_fiducial && nj.truth >= 1) {
-        h_pT_j1_truth->Fill(pT_j1.truth,weight);
-        h_x1_truth->Fill(x1.truth,weight);
+        h_pT_j1_truth(pT_j1.truth,weight);
+        h_x1_truth(x1.truth,weight);
         // if (x1.truth > 1) ++n1_truth;
       }
 
@@ -249,12 +293,12 @@ int main(int argc, char* argv[]) {
 
       // if (x2.det > 1) ++n2;
 
-      h_pT_j2->Fill(pT_j2.det,weight);
-      h_x2->Fill(x2.det,weight);
+      h_pT_j2(pT_j2.det,weight);
+      h_x2(x2.det,weight);
 
       if (is_fiducial && nj.truth >= 2) {
-        h_pT_j2_truth->Fill(pT_j2.truth,weight);
-        h_x2_truth->Fill(x2.truth,weight);
+        h_pT_j2_truth(pT_j2.truth,weight);
+        h_x2_truth(x2.truth,weight);
         // if (x2.truth > 1) ++n2_truth;
       }
 
@@ -265,18 +309,22 @@ int main(int argc, char* argv[]) {
 
       // if (x3.det > 1) ++n3;
 
-      h_pT_j3->Fill(pT_j3.det,weight);
-      h_x3->Fill(x3.det,weight);
+      h_pT_j3(pT_j3.det,weight);
+      h_x3(x3.det,weight);
 
       if (is_fiducial && nj.truth >= 3) {
-        h_pT_j3_truth->Fill(pT_j3.truth,weight);
-        h_x3_truth->Fill(x3.truth,weight);
+        h_pT_j3_truth(pT_j3.truth,weight);
+        h_x3_truth(x3.truth,weight);
         // if (x3.truth > 1) ++n3_truth;
       }
 
     }
   }
 
+  // no truth histograms for data
+  fout->cd();
+  for (const hist* h : hist::all)
+    if (is_mc || h->name.find("_truth")==std::string::npos) h->th1();
   fout->Write();
 
   test(n0)
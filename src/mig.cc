@@ -9,13 +9,14 @@
 #include <TTreeReader.h>
 #include <TTreeReaderValue.h>
 #include <TH1.h>
-#include <TKey.h>
 
 #include "binner.hh"
+#include "sparse_bins.hh"
 #include "re_axes.hh"
 #include "catstr.hh"
 #include "timed_counter.hh"
 #include "array_ops.hh"
+#include "mxaod_pool.hh"
 
 #define test(var) \
   std::cout <<"\033[36m"<< #var <<"\033[0m"<< " = " << var << std::endl;
@@ -35,30 +36,27 @@ var<bool> passed;
 // ==================================================================
 
 struct hist_bin {
-  static double weight;
-  double tmp, w;
+  static double weight; // includes the per-file normalization
+  double w;
 
-  inline hist_bin& operator++() noexcept { tmp += weight; return *this; }
-
-  void merge() noexcept {
-    w += tmp*n_all_inv;
-    tmp = 0;
-  }
+  inline hist_bin& operator++() noexcept { w += weight; return *this; }
 };
 double hist_bin::weight;
 
+// most of the weight is near the diagonal, so bins are stored sparsely
 template <typename T>
 using hist = ivanp::binner<hist_bin, ivanp::tuple_of_same_t<
-  ivanp::axis_spec<migration_axis<T>,true,true>,2>>;
-  // ivanp::axis_spec<migration_axis<T>,false,false>,2>>;
+  ivanp::axis_spec<migration_axis<T>,true,true>,2>,
+  // ivanp::axis_spec<migration_axis<T>,false,false>,2>,
+  ivanp::sparse_bins<hist_bin>>;
 
 auto make_hist(const char* name, const re_axes& ra, unsigned nchecks) {
   migration_axis<double> axis(&*ra[name],nchecks);
   return hist<double>( name, axis, axis );
 }
 
-template <typename A, typename T, typename... B>
-void fill(ivanp::binner<hist_bin,std::tuple<A,A>>& h,
+template <typename A, typename C, typename T, typename... B>
+void fill(ivanp::binner<hist_bin,std::tuple<A,A>,C>& h,
   const var<T>& x, const var<B>&... checks
 ) {
   h( std::tie(x.det,   passed.det,   checks.det...),
@@ -66,8 +64,8 @@ void fill(ivanp::binner<hist_bin,std::tuple<A,A>>& h,
 }
 
 template <typename A>
-std::ostream& operator<<(std::ostream& o,
-  const ivanp::named_ptr<ivanp::binner<hist_bin,std::tuple<A,A>>>& h
+std::ostream& operator<<(std::ostream& o, const ivanp::named_ptr<
+  ivanp::binner<hist_bin,std::tuple<A,A>,ivanp::sparse_bins<hist_bin>>>& h
 ) {
   std::ios::fmtflags f(cout.flags());
   auto prec = cout.precision();
@@ -75,11 +73,17 @@ std::ostream& operator<<(std::ostream& o,
   cout << std::fixed;
 
   o << "\033[32m" << h.name << "\033[0m\n";
-  const unsigned n = h->axis().nbins() + A::nover::value;
-  unsigned i = 0;
-  for (auto& b : h->bins()) {
-    cout << ' ' << std::setw(7) << b.w*lumi;
-    if (++i == n) { cout << endl; i = 0; }
+  // bins must be compressed
+  const auto& bins = h->bins();
+  const unsigned n = bins.row_length();
+  for (size_t r=0, nrows=bins.nrows(); r<nrows; ++r) {
+    auto k = bins.row_begin(r);
+    const auto end = bins.row_end(r);
+    for (unsigned c=0; c<n; ++c) {
+      const double w = (k!=end && bins.col(k)==c) ? bins.val(k++).w : 0.;
+      cout << ' ' << std::setw(7) << w*lumi;
+    }
+    cout << endl;
   }
 
   cout.flags(f);
@@ -95,8 +99,7 @@ int main(int argc, char* argv[]) {
   const std::array<double,2> myy_range{105e3,160e3};
   // const std::array<double,2> myy_range{121e3,129e3};
 
-  std::vector<std::unique_ptr<TFile>> mxaods;
-  mxaods.reserve(argc-2);
+  mxaod_pool mxaods;
   bool lumi_arg = false;
   for (int a=1; a<argc; ++a) { // loop over arguments
     // validate args and parse names of input files
@@ -110,8 +113,7 @@ int main(int argc, char* argv[]) {
     const char *arg = argv[a], *end = arg+std::strlen(arg);
     if (std::regex_search(arg,end,match,mc_re)) { // MC
       cout << "\033[36mMC\033[0m: " << arg << endl;
-      mxaods.emplace_back(new TFile(arg,"read"));
-      if (mxaods.back()->IsZombie()) return 1;
+      mxaods.emplace_back(arg,true);
     } else if (std::regex_search(arg,end,match,lumi_re)) {
       if (lumi_arg) {
         cerr << "arg error: repeated lumi arg: " << arg << endl;
@@ -149,26 +151,16 @@ int main(int argc, char* argv[]) {
   h_(pT_yy_0j,2) h_(pT_yy_1j,2) h_(pT_yy_2j,2) h_(pT_yy_3j,2)
   h_(pT_j1_excl,2)
 
-  for (auto& file : mxaods) { // loop over MxAODs
+  while (mxaod file = mxaods.next()) { // loop over MxAODs
     cout << "\033[36mMC\033[0m: " << file->GetName() << endl;
 
-    { TIter next(file->GetListOfKeys());
-      TKey *key;
-      while ((key = static_cast<TKey*>(next()))) {
-        std::string name(key->GetName());
-        if (name.substr(0,8)!="CutFlow_" ||
-            name.substr(name.size()-18)!="_noDalitz_weighted") continue;
-        TH1 *h = static_cast<TH1*>(key->ReadObj());
-        cout << h->GetName() << endl;
-        n_all_inv = h->GetBinContent(3);
-        cout << h->GetXaxis()->GetBinLabel(3) << " = " << n_all_inv << endl;
-        n_all_inv = 1./n_all_inv;
-        break;
-      }
-    }
+    const file_info& info = file.info();
+    cout << info.cutflow << endl;
+    cout << "sum of weights = " << info.n_all << endl;
+    n_all_inv = 1./info.n_all;
 
     // read variables ===============================================
-    TTreeReader reader("CollectionTree",file.get());
+    TTreeReader reader("CollectionTree",*file);
     TTreeReaderValue<Char_t> _isPassed(reader,"HGamEventInfoAuxDyn.isPassed");
     TTreeReaderValue<Float_t> _cs_br_fe(reader,
       "HGamEventInfoAuxDyn.crossSectionBRfilterEff");
@@ -203,7 +195,7 @@ int main(int argc, char* argv[]) {
       const auto m_yy = *_m_yy;
       if (!in(m_yy.det,myy_range)) continue;
 
-      hist_bin::weight = (*_weight)*(*_cs_br_fe);
+      hist_bin::weight = (*_weight)*(*_cs_br_fe)*n_all_inv;
       // test( hist_bin::weight )
 
       passed = {*_isPassed,*_isFiducial && in(m_yy.truth,myy_range)};
@@ -254,14 +246,12 @@ int main(int argc, char* argv[]) {
       fill(h_pT_yyjj, _pT_yyjj/1e3, nj>=2);
     }
 
-    for (const auto& h : hist<Int_t>::all)
-      for (auto& b : h->bins()) b.merge();
-    for (const auto& h : hist<double>::all)
-      for (auto& b : h->bins()) b.merge();
-
     file->Close();
   }
 
+  for (const auto& h : hist<Int_t>::all) h->bins().compress(h->nbins());
+  for (const auto& h : hist<double>::all) h->bins().compress(h->nbins());
+
   cout << endl;
   for (const auto& h : hist<Int_t>::all) cout << h << endl;
   for (const auto& h : hist<double>::all) cout << h << endl;
@@ -0,0 +1,85 @@
+#ifndef IVANP_MXAOD_CHAIN_HH
+#define IVANP_MXAOD_CHAIN_HH
+
+#include <vector>
+#include <array>
+#include <functional>
+#include <algorithm>
+
+#include <TChain.h>
+#include <TEntryList.h>
+#include <TTreeReader.h>
+
+#include "catalog.hh"
+#include "entry_cache.hh"
+
+/*
+ * Reads CollectionTree of a sequence of MxAODs as one TChain
+ *
+ * Branch readers are bound to reader() once for all files,
+ * and the TTreeCache is carried over from file to file.
+ * The cache is sized to the largest cluster of the files, from the
+ * catalog, up to cache_size.
+ * Only entries passing isPassed and myy_range are read.
+ * The on_file callback is called with the catalog entry of each file
+ * before its first event, e.g. to switch the normalization.
+ *
+ * All files in a chain must have the same branches,
+ * so data and MC are chained separately.
+ */
+
+class mxaod_chain {
+  TChain _chain;
+  TEntryList _elist;
+  std::vector<const file_info*> _files;
+  TTreeReader _reader;
+  std::function<void(const file_info&)> _on_file;
+  Int_t _tree;
+
+public:
+  mxaod_chain(
+    const std::vector<const file_info*>& files,
+    const std::array<double,2>& myy_range,
+    Long64_t cache_size = 64*1024*1024
+  ): _chain("CollectionTree"), _tree(-1) {
+    _elist.SetDirectory(nullptr); // owned here, not by a file
+    long long max_cluster = 0;
+    for (const file_info* f : files) {
+      if (!f->entries) continue;
+      const auto entries =
+        selected_entries(f->name.c_str(),"CollectionTree",myy_range);
+      TEntryList sub("","","CollectionTree",f->name.c_str());
+      sub.SetDirectory(nullptr);
+      for (const auto ent : entries) sub.Enter(ent);
+      _elist.Add(&sub);
+      _chain.Add(f->name.c_str(),f->entries);
+      _files.push_back(f);
+      max_cluster = std::max(max_cluster,cluster_bytes(*f));
+    }
+    _chain.SetCacheSize(max_cluster > 0
+      ? std::min<Long64_t>(max_cluster,cache_size) : cache_size);
+    _chain.SetEntryList(&_elist);
+    _reader.SetTree(&_chain,&_elist);
+  }
+  mxaod_chain(const mxaod_chain&) = delete;
+  mxaod_chain& operator=(const mxaod_chain&) = delete;
+
+  inline TTreeReader& reader() noexcept { return _reader; }
+  inline Long64_t entries() const noexcept { return _elist.GetN(); }
+  inline size_t nfiles() const noexcept { return _files.size(); }
+
+  template <typename F>
+  inline void on_file(F&& f) { _on_file = std::forward<F>(f); }
+
+  bool next() {
+    if (!_reader.Next()) return false;
+    const Int_t tree = _chain.GetTreeNumber();
+    if (tree != _tree) {
+      _tree = tree;
+      if (_on_file) _on_file(*_files[tree]);
+    }
+    return true;
+  }
+};
+
+#endif
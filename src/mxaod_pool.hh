@@ -0,0 +1,117 @@
+#ifndef IVANP_MXAOD_POOL_HH
+#define IVANP_MXAOD_POOL_HH
+
+#include <string>
+#include <vector>
+#include <deque>
+#include <future>
+#include <memory>
+#include <utility>
+#include <algorithm>
+
+#include <TFile.h>
+#include <TTree.h>
+#include <TROOT.h>
+
+#include "exception.hh"
+#include "catalog.hh"
+
+class mxaod {
+  std::unique_ptr<TFile> ptr;
+  const file_info *_info;
+public:
+  mxaod(): ptr(nullptr), _info(nullptr) { }
+  mxaod(const file_info& info)
+  : ptr(new TFile(info.name.c_str(),"read")), _info(&info) {
+    if (ptr->IsZombie())
+      throw ivanp::exception("cannot open file ",info.name);
+  }
+  inline TFile* operator->() const noexcept { return ptr.get(); }
+  inline TFile* operator* () const noexcept { return ptr.get(); }
+  inline const file_info& info() const noexcept { return *_info; }
+  inline bool is_mc() const noexcept { return _info->is_mc; }
+  explicit inline operator bool() const noexcept { return bool(ptr); }
+};
+
+/*
+ * Opens input files on demand, in order
+ *
+ * While the current file is processed, following files are opened
+ * on background threads, reading their keys, streamer info
+ * and CollectionTree metadata.
+ * Files are opened ahead until their sizes from the catalog add up to
+ * ahead_bytes, so that many small files are opened further ahead than
+ * a few large ones, but at least 1 and at most max_ahead files.
+ * The TTreeCache of each file is sized to its largest cluster from
+ * the catalog, up to cache_bytes, so that every cluster is read
+ * in one pass without reserving more memory than it needs.
+ * A file is closed and freed when the mxaod returned by next()
+ * is destroyed.
+ * Before the first file is opened, the catalog of all inputs is
+ * built (or read from cache). Files with empty trees are skipped.
+ *
+ *   while (mxaod file = pool.next()) { ... }
+ */
+
+class mxaod_pool {
+  std::vector<std::pair<std::string,bool>> inputs;
+  std::vector<file_info> _catalog;
+  std::deque<std::pair<std::future<mxaod>,long long>> opening; // and size
+  size_t next_input, max_ahead;
+  long long ahead_bytes, opening_bytes, cache_bytes;
+
+  void open_more() {
+    while (next_input < _catalog.size() && (opening.empty() ||
+      (opening.size() < max_ahead && opening_bytes < ahead_bytes)
+    )) {
+      const file_info& info = _catalog[next_input++];
+      if (!info.entries) continue;
+      opening_bytes += info.size;
+      opening.emplace_back(std::async(std::launch::async,
+        [&info,cache=cache_bytes]{
+          mxaod file(info);
+          TTree *tree = nullptr;
+          file->GetObject("CollectionTree",tree);
+          if (tree) {
+            const long long bytes = cluster_bytes(info);
+            if (bytes > 0) tree->SetCacheSize(std::min(bytes,cache));
+          }
+          return file;
+        }), info.size);
+    }
+  }
+
+public:
+  mxaod_pool(long long ahead_bytes = 4ll<<30, size_t max_ahead = 8,
+    long long cache_bytes = 64ll<<20)
+  : next_input(0), max_ahead(std::max<size_t>(max_ahead,1)),
+    ahead_bytes(ahead_bytes), opening_bytes(0), cache_bytes(cache_bytes) {
+    ROOT::EnableThreadSafety();
+  }
+  mxaod_pool(const mxaod_pool&) = delete;
+  mxaod_pool& operator=(const mxaod_pool&) = delete;
+
+  void emplace_back(const char* fname, bool is_mc) {
+    inputs.emplace_back(fname,is_mc);
+  }
+  inline size_t size() const noexcept { return inputs.size(); }
+
+  const std::vector<file_info>& catalog() {
+    if (_catalog.size() != inputs.size()) _catalog = make_catalog(inputs);
+    return _catalog;
+  }
+
+  // returns an empty mxaod after the last file
+  mxaod next() {
+    catalog();
+    open_more();
+    if (opening.empty()) return { };
+    mxaod file = opening.front().first.get();
+    opening_bytes -= opening.front().second;
+    opening.pop_front();
+    open_more();
+    return file;
+  }
+};
+
+#endif
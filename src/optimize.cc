@@ -1,9 +1,20 @@
 #include <iostream>
+#include <fstream>
+#include <limits>
+#include <cstring>
+#include <cstdlib>
+#include <vector>
 #include <algorithm>
 #include <cmath>
+#include <chrono>
+#include <future>
+#include <atomic>
+#include <thread>
 
 #include <TFile.h>
+#include <TTree.h>
 #include <TH1.h>
+#include <TH2.h>
 #include <TKey.h>
 #include <TVectorT.h>
 
@@ -32,56 +43,406 @@ inline unsigned nbins(const H1* h1, const H2* h2, const Hs*... hs) {
   return n1;
 }
 
-struct var_sb {
-  struct sb {
-    double sig, bkg, up;
-    sb(): sig(0.), bkg(0.), up(0.) { }
-    sb(double sig, double bkg, double up): sig(sig), bkg(bkg), up(up) { }
-    inline void operator+=(const sb& x) noexcept {
-      sig += x.sig;
-      bkg += x.bkg;
-      up = x.up;
-    }
-    inline double signif() const noexcept {
-      const double spb = sig + bkg;
-      return (__builtin_expect(spb>0.,1) ? sig/sqrt(spb) : 0.);
+std::vector<double> numbers(const char* str) {
+  std::vector<double> xs;
+  for (const char* p=str; ; ++p) {
+    char* end;
+    xs.push_back(std::strtod(p,&end));
+    if (end==p) throw exception("bad number list \'",str,"\'");
+    p = end;
+    if (*p!=',') {
+      if (*p) throw exception("bad number list \'",str,"\'");
+      break;
     }
-  };
+  }
+  return xs;
+}
+
+// Fiducial det x truth migration over fine bins [0,n),
+// stored both by rows (det) and by columns (truth)
+struct migration {
+  struct csr {
+    std::vector<unsigned> ptr, idx;
+    std::vector<double> w;
+  } rows, cols;
+  std::vector<double> reco; // prefix sums of all MC weight by det bin
+
+  migration() = default;
+  migration(unsigned n, TH1D* hreco, TTree* tree): reco(n+1) {
+    const auto * reco_arr = hreco->GetArray();
+    reco[0] = 0.;
+    for (unsigned i=1; i<=n; ++i) reco[i] = reco[i-1] + reco_arr[i];
+
+    UInt_t det, truth;
+    Double_t w;
+    tree->SetBranchAddress("det",&det);
+    tree->SetBranchAddress("truth",&truth);
+    tree->SetBranchAddress("w",&w);
+    std::vector<std::array<unsigned,2>> dt;
+    std::vector<double> ws;
+    for (Long64_t ent=0, nent=tree->GetEntries(); ent<nent; ++ent) {
+      tree->GetEntry(ent);
+      // skip underflow and overflow
+      if (det<1 || det>n || truth<1 || truth>n) continue;
+      dt.push_back({det-1,truth-1});
+      ws.push_back(w);
+    }
+    fill(rows,n,dt,ws,0);
+    fill(cols,n,dt,ws,1);
+  }
+
+  inline bool empty() const noexcept { return reco.empty(); }
+
+  // weight of events with both det and truth in fine bins [a,b)
+  double diag(unsigned a, unsigned b) const {
+    double sum = 0.;
+    for (unsigned d=a; d<b; ++d) {
+      const auto begin = rows.idx.begin()+rows.ptr[d];
+      const auto end   = rows.idx.begin()+rows.ptr[d+1];
+      for (auto it=std::lower_bound(begin,end,a); it!=end && *it<b; ++it)
+        sum += rows.w[it-rows.idx.begin()];
+    }
+    return sum;
+  }
+
+private:
+  // counting sort by det (i=0) or truth (i=1),
+  // then each row is sorted by the other index, as diag() requires,
+  // whatever the order of the entries in the input tree
+  static void fill(csr& m, unsigned n,
+    const std::vector<std::array<unsigned,2>>& dt,
+    const std::vector<double>& ws, unsigned i
+  ) {
+    m.ptr.assign(n+1,0);
+    for (const auto& x : dt) ++m.ptr[x[i]+1];
+    for (unsigned k=0; k<n; ++k) m.ptr[k+1] += m.ptr[k];
+    m.idx.resize(dt.size());
+    m.w.resize(dt.size());
+    auto pos = m.ptr;
+    for (size_t k=0; k<dt.size(); ++k) {
+      const auto p = pos[dt[k][i]]++;
+      m.idx[p] = dt[k][!i];
+      m.w[p] = ws[k];
+    }
+    std::vector<std::pair<unsigned,double>> row;
+    for (unsigned k=0; k<n; ++k) {
+      const auto first = m.ptr[k], last = m.ptr[k+1];
+      if (std::is_sorted(m.idx.begin()+first,m.idx.begin()+last)) continue;
+      row.clear();
+      for (auto p=first; p<last; ++p) row.emplace_back(m.idx[p],m.w[p]);
+      std::stable_sort(row.begin(),row.end(),
+        [](const std::pair<unsigned,double>& a,
+           const std::pair<unsigned,double>& b){ return a.first < b.first; });
+      for (auto p=first; p<last; ++p) {
+        m.idx[p] = row[p-first].first;
+        m.w[p] = row[p-first].second;
+      }
+    }
+  }
+};
+
+struct var_sb {
   std::string name;
-  double low;
-  std::vector<sb> bins;
+  unsigned n; // number of fine bins
+  std::vector<double> edges; // fine bin edges, need not be uniform
+  // prefix sums over fine bins, sig[i] is the sum of bins [0,i)
+  std::vector<double> sig, bkg;
+  migration mig; // empty if not in the input
 
   template <typename Name>
-  var_sb(Name&& name, TH1D* sig, TH1D* bkg)
-  : name(std::forward<Name>(name)), low(sig->GetBinLowEdge(1)) {
-    const unsigned n = nbins(sig,bkg);
-    bins.reserve(n);
-    auto * sig_arr = sig->GetArray();
-    auto * bkg_arr = bkg->GetArray();
+  var_sb(Name&& name, TH1D* hsig, TH1D* hbkg)
+  : name(std::forward<Name>(name)),
+    n(nbins(hsig,hbkg)), edges(n+1), sig(n+1), bkg(n+1)
+  {
+    for (unsigned i=0; i<=n; ++i) edges[i] = hsig->GetBinLowEdge(i+1);
+    const auto * sig_arr = hsig->GetArray();
+    const auto * bkg_arr = hbkg->GetArray();
+    sig[0] = bkg[0] = 0.;
     for (unsigned i=1; i<=n; ++i) {
-      bins.emplace_back(sig_arr[i],bkg_arr[i],sig->GetBinLowEdge(i+1));
+      sig[i] = sig[i-1] + sig_arr[i];
+      bkg[i] = bkg[i-1] + bkg_arr[i];
     }
   }
-  inline sb& operator[](unsigned i) noexcept { return bins[i]; }
+
+  inline double edge(unsigned i) const noexcept { return edges[i]; }
+
+  // purity of fine bins [a,b)
+  inline double purity(unsigned a, unsigned b) const {
+    if (mig.empty()) return std::numeric_limits<double>::quiet_NaN();
+    return mig.diag(a,b)/(mig.reco[b]-mig.reco[a]);
+  }
+
+  // significance of fine bins [a,b)
+  inline double signif(unsigned a, unsigned b) const noexcept {
+    const double s = sig[b]-sig[a], spb = s + bkg[b]-bkg[a];
+    return (__builtin_expect(spb>0.,1) ? s/sqrt(spb) : 0.);
+  }
+};
+
+struct rect { unsigned x0, x1, y0, y1; }; // fine bins [x0,x1)x[y0,y1)
+
+struct var2_sb {
+  std::string name;
+  unsigned nx, ny; // number of fine bins
+  std::array<std::vector<double>,2> edges; // fine bin edges along x and y
+  // summed-area tables, sig[x+(nx+1)*y] is the sum of bins [0,x)x[0,y)
+  std::vector<double> sig, bkg;
+
+  template <typename Name>
+  var2_sb(Name&& name, TH2D* hsig, TH2D* hbkg)
+  : name(std::forward<Name>(name)),
+    nx(nbins(hsig,hbkg)), ny(hsig->GetNbinsY()),
+    sig((nx+1)*(ny+1)), bkg((nx+1)*(ny+1))
+  {
+    if (hbkg->GetNbinsY()!=int(ny)) throw exception(
+      "histogram ",hbkg->GetName()," has ",hbkg->GetNbinsY(),
+      " y bins instead of expected ",ny);
+    const TAxis *ax = hsig->GetXaxis(), *ay = hsig->GetYaxis();
+    edges[0].resize(nx+1);
+    edges[1].resize(ny+1);
+    for (unsigned x=0; x<=nx; ++x) edges[0][x] = ax->GetBinLowEdge(x+1);
+    for (unsigned y=0; y<=ny; ++y) edges[1][y] = ay->GetBinLowEdge(y+1);
+    const auto * sig_arr = hsig->GetArray();
+    const auto * bkg_arr = hbkg->GetArray();
+    for (unsigned y=0; y<=ny; ++y)
+      for (unsigned x=0; x<=nx; ++x) {
+        if (!x || !y) { sig[at(x,y)] = bkg[at(x,y)] = 0.; continue; }
+        const unsigned bin = x + (nx+2)*y; // skip under and overflow
+        sig[at(x,y)] = sig_arr[bin]
+          + sig[at(x-1,y)] + sig[at(x,y-1)] - sig[at(x-1,y-1)];
+        bkg[at(x,y)] = bkg_arr[bin]
+          + bkg[at(x-1,y)] + bkg[at(x,y-1)] - bkg[at(x-1,y-1)];
+      }
+  }
+
+  inline unsigned at(unsigned x, unsigned y) const noexcept {
+    return x + (nx+1)*y;
+  }
+  inline double sum(const std::vector<double>& t, const rect& r)
+  const noexcept {
+    return t[at(r.x1,r.y1)] - t[at(r.x0,r.y1)]
+         - t[at(r.x1,r.y0)] + t[at(r.x0,r.y0)];
+  }
+  inline double edge(unsigned i, unsigned x) const noexcept {
+    return edges[i][x];
+  }
+
+  inline double signif(const rect& r) const noexcept {
+    const double s = sum(sig,r), spb = s + sum(bkg,r);
+    return (__builtin_expect(spb>0.,1) ? s/sqrt(spb) : 0.);
+  }
+};
+
+// Prefix sums with point updates
+class prefix_tree {
+  std::vector<double> t;
+public:
+  prefix_tree(unsigned n): t(n+1,0.) { }
+  inline void add(unsigned i, double x) noexcept {
+    for (++i; i<t.size(); i+=i&-i) t[i] += x;
+  }
+  // sum of [0,i)
+  inline double sum(unsigned i) const noexcept {
+    double s = 0.;
+    for (; i; i-=i&-i) s += t[i];
+    return s;
+  }
 };
 
+// Binning with the largest number of bins, such that every bin has
+// significance of at least target, purity of at least min_purity,
+// and is at least min_width wide in units of the variable
+// Returns fine bin edges, or nothing if the whole range does not qualify
+//
+// f[i] is the largest number of bins partitioning fine bins [0,i),
+// or -1 if there is no such partition.
+// The last bin [j,i) is found scanning j down from the largest start
+// at least min_width below edge i, which only moves up with i,
+// until the running maximum of f below j cannot improve on the best found.
+// Aligned blocks of 2^k starts are skipped at once if the block's
+// maximum of f is too small, or if the most signal and least background
+// any start in the block can give are not enough to reach the target.
+//
+// Purity of [j,i) needs the fiducial weight with det and truth in [j,i),
+// which is G(i,i) - G(j,i) - G(i,j) + G(j,j), where G(x,y) is the weight
+// with det < x and truth < y. Going up in i, rows below i are added to
+// a prefix tree over truth, and columns below i to one over det,
+// so that G(i,j) and G(j,i) take O(log n).
+std::vector<unsigned> optimize(
+  const var_sb& var, double target, double min_width, double min_purity
+) {
+  const unsigned n = var.n;
+  // allow for rounding of edges
+  min_width -= 1e-9*(var.edges[n]-var.edges[0]);
+  const bool purity = min_purity > 0.;
+  if (purity && var.mig.empty()) throw exception(
+    "no migration for ",var.name,", rerun superfine");
+  prefix_tree by_truth(purity ? n : 0), by_det(purity ? n : 0);
+  std::vector<double> G(purity ? n+1 : 0, 0.);
+  const auto pure = [&](unsigned j, unsigned i){
+    const double reco = var.mig.reco[i] - var.mig.reco[j];
+    if (!(reco > 0.)) return false;
+    const double diag = G[i] - by_det.sum(j) - by_truth.sum(j) + G[j];
+    return diag >= min_purity*reco;
+  };
+
+  std::vector<int> f(n+1,-1), fmax(n+1,-1);
+  std::vector<unsigned> prev(n+1,0);
+
+  // block minima of sig and maxima of bkg and f
+  unsigned K = 0;
+  while ((2u<<K) <= n+1) ++K;
+  std::vector<std::vector<double>> smin(K+1), bmax(K+1);
+  std::vector<std::vector<int>> fblk(K+1);
+  smin[0] = var.sig;
+  bmax[0] = var.bkg;
+  for (unsigned k=1; k<=K; ++k) {
+    const unsigned size = (n+1)>>k;
+    smin[k].resize(size);
+    bmax[k].resize(size);
+    fblk[k].assign(size,-1);
+    for (unsigned m=0; m<size; ++m) {
+      smin[k][m] = std::min(smin[k-1][2*m],smin[k-1][2*m+1]);
+      bmax[k][m] = std::max(bmax[k-1][2*m],bmax[k-1][2*m+1]);
+    }
+  }
+  const auto set_f = [&](unsigned i, int x){
+    f[i] = x;
+    fmax[i] = i ? std::max(fmax[i-1],x) : x;
+    for (unsigned k=1; k<=K && (i>>k) < fblk[k].size(); ++k)
+      fblk[k][i>>k] = std::max(fblk[k][i>>k],x);
+  };
+  // can no start in block m of level k give a bin ending at i?
+  const auto skip = [&](unsigned k, unsigned m, unsigned i, int fmin){
+    if (fblk[k][m] < fmin) return true;
+    if (target <= 0.) return false;
+    const double s = var.sig[i] - smin[k][m], b = var.bkg[i] - bmax[k][m];
+    if (s <= 0.) return true;
+    if (b < 0.) return false;
+    return s/sqrt(s+b) < target;
+  };
+
+  set_f(0,0);
+  unsigned lim = 0; // starts [0,lim) are at least min_width below i
+  for (unsigned i=1; i<=n; ++i) {
+    while (lim < i && var.edges[i]-var.edges[lim] >= min_width) ++lim;
+
+    if (purity) {
+      const auto& rows = var.mig.rows;
+      for (auto k=rows.ptr[i-1]; k<rows.ptr[i]; ++k)
+        by_truth.add(rows.idx[k],rows.w[k]);
+      const auto& cols = var.mig.cols;
+      for (auto k=cols.ptr[i-1]; k<cols.ptr[i]; ++k)
+        by_det.add(cols.idx[k],cols.w[k]);
+      G[i] = by_truth.sum(i);
+    }
+
+    int best = -1;
+    for (long j=long(lim)-1; j>=0; ) {
+      if (fmax[j] < best) break;
+      const int fmin = std::max(best,0);
+      unsigned k = std::min<unsigned>(K,__builtin_ctzl(j+1));
+      for (; k; --k)
+        if (skip(k,((j+1)>>k)-1,i,fmin)) break;
+      if (k) { j -= 1l<<k; continue; }
+      if (f[j] >= fmin && var.signif(j,i) >= target
+          && (!purity || pure(j,i))) {
+        best = f[j] + 1;
+        prev[i] = j;
+      }
+      --j;
+    }
+    set_f(i,best);
+  }
+
+  std::vector<unsigned> edges;
+  if (f[n] < 1) return edges;
+  for (unsigned i=n; i; i=prev[i]) edges.push_back(i);
+  edges.push_back(0);
+  std::reverse(edges.begin(),edges.end());
+  return edges;
+}
+
+// Hierarchical partition of a 2D grid into rectangles,
+// each with significance of at least target
+// Starting from the whole grid, every rectangle is split in two along
+// the fine x or y edge that maximizes the smaller significance
+// of the two parts, as long as both reach the target.
+// Every candidate split is evaluated in O(1) from the summed-area tables.
+std::vector<rect> optimize(const var2_sb& var, double target) {
+  std::vector<rect> leaves, stack{{0,var.nx,0,var.ny}};
+  if (var.signif(stack.front()) < target) return leaves;
+
+  while (!stack.empty()) {
+    const rect r = stack.back();
+    stack.pop_back();
+
+    double best = target;
+    rect a, b;
+    bool split = false;
+    const auto try_split = [&](const rect& r1, const rect& r2){
+      const double m = std::min(var.signif(r1),var.signif(r2));
+      if (m >= best) {
+        best = m;
+        a = r1;
+        b = r2;
+        split = true;
+      }
+    };
+    for (unsigned x=r.x0+1; x<r.x1; ++x)
+      try_split({r.x0,x,r.y0,r.y1},{x,r.x1,r.y0,r.y1});
+    for (unsigned y=r.y0+1; y<r.y1; ++y)
+      try_split({r.x0,r.x1,r.y0,y},{r.x0,r.x1,y,r.y1});
+
+    if (split) {
+      stack.push_back(b);
+      stack.push_back(a);
+    } else leaves.push_back(r);
+  }
+  return leaves;
+}
+
 int main(int argc, char* argv[])
 {
-  const double fl = std::sqrt(atof(argv[2]));
-  const double signif = atof(argv[3]);
+  // out:FILE and purity:X may be given anywhere,
+  // the other arguments are positional
+  const char* fout_name = nullptr;
+  double min_purity = 0.;
+  std::vector<const char*> args;
+  for (int a=1; a<argc; ++a) {
+    if (!std::strncmp(argv[a],"out:",4)) fout_name = argv[a]+4;
+    else if (!std::strncmp(argv[a],"purity:",7)) min_purity = atof(argv[a]+7);
+    else args.push_back(argv[a]);
+  }
+  if (args.size()<3 || args.size()>4) {
+    cout << "usage: " << argv[0]
+         << " superfine.root lumi_ratio signif [min_width]"
+            " [purity:min] [out:table]\n"
+            "  lumi_ratio and signif can be comma separated lists"
+         << endl;
+    return 1;
+  }
+  const auto lumi_ratios = numbers(args[1]);
+  const auto targets = numbers(args[2]);
+  const double min_width = args.size()>3 ? atof(args[3]) : 0.;
+  const bool batch = lumi_ratios.size()*targets.size() > 1;
+  if (batch && !fout_name) fout_name = "optimize.tsv";
 
-  test(signif)
+  test(min_width)
+  test(min_purity)
 
-  auto fin = std::make_unique<TFile>(argv[1],"read");
+  auto fin = std::make_unique<TFile>(args[0],"read");
   if (fin->IsZombie()) return 1;
   cout << "Input file: " << fin->GetName() << endl;
 
   std::vector<var_sb> vars;
+  std::vector<var2_sb> vars2;
 
   {
     TIter next(fin->GetListOfKeys());
     TKey *key;
-    std::vector<std::pair<std::string,std::array<TKey*,2>>> hbuff;
+    static const std::array<std::string,4> types {"sig","bkg","reco","mig"};
+    std::vector<std::pair<std::string,std::array<TKey*,4>>> hbuff, hbuff2;
     while ((key = static_cast<TKey*>(next()))) {
       std::string name(key->GetName());
       auto sep = name.rfind('_');
@@ -89,19 +450,21 @@ int main(int argc, char* argv[])
         name.substr(0,sep), name.substr(sep+1)
       };
 
-      if (!(var[1]=="sig" || var[1]=="bkg")) continue;
+      const auto type = std::find(types.begin(),types.end(),var[1]);
+      if (type==types.end()) continue;
 
-      auto rit = std::find_if(hbuff.rbegin(),hbuff.rend(),
+      auto& buff = std::strcmp(key->GetClassName(),"TH2D") ? hbuff : hbuff2;
+      auto rit = std::find_if(buff.rbegin(),buff.rend(),
         [&name = var[0]](decltype(hbuff)::const_reference x){
           return (x.first == name);
         }
       );
-      if (rit==hbuff.rend()) {
+      if (rit==buff.rend()) {
         using second_t = decltype(hbuff)::value_type::second_type;
-        hbuff.emplace_back(var[0],second_t{nullptr,nullptr});
-        rit = hbuff.rbegin();
+        buff.emplace_back(var[0],second_t{nullptr,nullptr,nullptr,nullptr});
+        rit = buff.rbegin();
       }
-      rit->second[var[1]=="sig" ? 0 : 1] = key;
+      rit->second[type-types.begin()] = key;
     }
     cout << "Variables:";
     for (auto& buff : hbuff) {
@@ -112,28 +475,171 @@ int main(int argc, char* argv[])
         return dynamic_cast<TH1D*>(buff.second[i]->ReadObj());
       };
       vars.emplace_back(buff.first,hist(0),hist(1));
+      // migration is only in newer superfine outputs
+      if (buff.second[2] && buff.second[3]) vars.back().mig = {
+        vars.back().n, hist(2),
+        dynamic_cast<TTree*>(buff.second[3]->ReadObj())
+      };
+    }
+    for (auto& buff : hbuff2) {
+      if (buff.second[0]==nullptr || buff.second[1]==nullptr)
+        throw exception("missing histograms for variable \'",buff.first,"\'");
+      cout << ' ' << buff.first;
+      auto hist = [&buff](unsigned i){ // get histogram from key
+        return dynamic_cast<TH2D*>(buff.second[i]->ReadObj());
+      };
+      vars2.emplace_back(buff.first,hist(0),hist(1));
     }
   }
   cout << '\n' << endl;
 
-  for (auto& var : vars) {
+  // optimize all combinations in parallel =========================
+  struct task {
+    const var_sb* var;
+    double lumi_ratio, signif;
+    std::vector<unsigned> edges;
+  };
+  struct task2 {
+    const var2_sb* var;
+    double lumi_ratio, signif;
+    std::vector<rect> rects;
+  };
+  std::vector<task> tasks;
+  std::vector<task2> tasks2;
+  tasks.reserve(vars.size()*lumi_ratios.size()*targets.size());
+  tasks2.reserve(vars2.size()*lumi_ratios.size()*targets.size());
+  for (double lumi_ratio : lumi_ratios)
+    for (double signif : targets) {
+      for (const auto& var : vars)
+        tasks.push_back({&var,lumi_ratio,signif,{}});
+      for (const auto& var : vars2)
+        tasks2.push_back({&var,lumi_ratio,signif,{}});
+    }
+  const size_t ntasks = tasks.size() + tasks2.size();
+
+  const auto start = std::chrono::steady_clock::now();
+
+  std::atomic<size_t> next(0);
+  std::vector<std::future<void>> workers;
+  const unsigned nthreads = std::min<size_t>(
+    std::max(1u,std::thread::hardware_concurrency()), ntasks);
+  for (unsigned t=0; t<nthreads; ++t)
+    workers.emplace_back(std::async(std::launch::async,[&]{
+      for (size_t i; (i = next++) < ntasks; ) {
+        if (i >= tasks.size()) {
+          auto& job = tasks2[i-tasks.size()];
+          job.rects = optimize(*job.var,job.signif/std::sqrt(job.lumi_ratio));
+          continue;
+        }
+        auto& job = tasks[i];
+        job.edges = optimize(*job.var,
+          job.signif/std::sqrt(job.lumi_ratio),min_width,min_purity);
+      }
+    }));
+  for (auto& w : workers) w.get();
+
+  const auto time = std::chrono::duration<double>(
+    std::chrono::steady_clock::now() - start).count();
+
+  for (const auto& t : tasks) {
+    const auto& var = *t.var;
+    const auto& e = t.edges;
+    const double fl = std::sqrt(t.lumi_ratio);
+    if (batch) {
+      cout << "\033[32m" << var.name << "\033[0m"
+           << " lumi_ratio=" << t.lumi_ratio << " signif=" << t.signif << ": ";
+      if (e.empty()) cout << "\033[31mtarget not reached\033[0m" << endl;
+      else cout << e.size()-1 << " bins" << endl;
+      continue;
+    }
     cout << "\033[32m" << var.name << "\033[0m" << endl;
-    cout << var.low << endl;
+    if (e.empty()) {
+      cout << "\033[31mtarget not reached\033[0m\n" << endl;
+      continue;
+    }
+    cout << var.edge(e[0]) << endl;
+    for (size_t i=1; i<e.size(); ++i)
+      cout << var.edge(e[i]) << ' ' << fl*var.signif(e[i-1],e[i])
+           << ' ' << var.purity(e[i-1],e[i]) << endl;
 
-    // for (auto& sb : var.bins) cout << sb.signif() << endl;
+    // binning in .bins format
+    cout << var.name << " {";
+    for (const auto i : e) cout << ' ' << var.edge(i);
+    cout << " }\n" << endl;
+  }
 
-    unsigned a = 0, b = 0, n = var.bins.size();
-    while (b<n) {
-      do {
-        var[a] += var[b++];
-        if (b==n) break;
-      } while (fl*var[a].signif()<signif || var[b].sig+var[b].bkg==0.);
+  for (const auto& t : tasks2) {
+    const auto& var = *t.var;
+    const double fl = std::sqrt(t.lumi_ratio);
+    cout << "\033[32m" << var.name << "\033[0m";
+    if (batch) cout << " lumi_ratio=" << t.lumi_ratio << " signif=" << t.signif
+                    << ": ";
+    else cout << endl;
+    if (t.rects.empty()) {
+      cout << "\033[31mtarget not reached\033[0m" << endl;
+      if (!batch) cout << endl;
+      continue;
+    }
+    if (batch) {
+      cout << t.rects.size() << " bins" << endl;
+      continue;
+    }
+    for (const auto& r : t.rects)
+      cout << "\033[35m[" << var.edge(0,r.x0) << ',' << var.edge(0,r.x1)
+           << ") [" << var.edge(1,r.y0) << ',' << var.edge(1,r.y1)
+           << ")\033[0m " << fl*var.signif(r) << endl;
+    cout << endl;
+  }
 
-      cout << var[a].up << ' ' << fl*var[a].signif() << endl;
-      a = b;
+  if (fout_name) {
+    // one row per bin, combinations that do not reach the target are omitted
+    std::ofstream fout(fout_name);
+    if (!fout) throw exception("cannot write ",fout_name);
+    fout << "# var\tlumi_ratio\tsignif_target\tbin\tlower\tupper"
+            "\tsig\tbkg\tsignif\tpurity\n";
+    fout.precision(std::numeric_limits<double>::max_digits10);
+    for (const auto& t : tasks) {
+      const auto& var = *t.var;
+      const auto& e = t.edges;
+      const double fl = std::sqrt(t.lumi_ratio);
+      for (size_t i=1; i<e.size(); ++i)
+        fout << var.name << '\t' << t.lumi_ratio << '\t' << t.signif << '\t'
+             << i << '\t' << var.edge(e[i-1]) << '\t' << var.edge(e[i]) << '\t'
+             << t.lumi_ratio*(var.sig[e[i]]-var.sig[e[i-1]]) << '\t'
+             << t.lumi_ratio*(var.bkg[e[i]]-var.bkg[e[i-1]]) << '\t'
+             << fl*var.signif(e[i-1],e[i]) << '\t'
+             << var.purity(e[i-1],e[i]) << '\n';
+    }
+    cout << "\033[36mOutput file\033[0m: " << fout_name << endl;
+  }
+  if (fout_name && !tasks2.empty()) {
+    // 2D partitions go to a separate table, FILE.tsv -> FILE_2d.tsv
+    std::string name(fout_name);
+    const auto dot = name.rfind('.');
+    name.insert(dot==std::string::npos || name.find('/',dot)!=std::string::npos
+      ? name.size() : dot, "_2d");
+    std::ofstream fout(name);
+    if (!fout) throw exception("cannot write ",name);
+    fout << "# var\tlumi_ratio\tsignif_target\tbin\tx_lower\tx_upper"
+            "\ty_lower\ty_upper\tsig\tbkg\tsignif\n";
+    fout.precision(std::numeric_limits<double>::max_digits10);
+    for (const auto& t : tasks2) {
+      const auto& var = *t.var;
+      const double fl = std::sqrt(t.lumi_ratio);
+      unsigned i = 0;
+      for (const auto& r : t.rects)
+        fout << var.name << '\t' << t.lumi_ratio << '\t' << t.signif << '\t'
+             << ++i << '\t' << var.edge(0,r.x0) << '\t' << var.edge(0,r.x1)
+             << '\t' << var.edge(1,r.y0) << '\t' << var.edge(1,r.y1) << '\t'
+             << t.lumi_ratio*var.sum(var.sig,r) << '\t'
+             << t.lumi_ratio*var.sum(var.bkg,r) << '\t'
+             << fl*var.signif(r) << '\n';
     }
+    cout << "\033[36mOutput file\033[0m: " << name << endl;
   }
 
+  cout << "Optimized " << ntasks << " binnings of "
+       << vars.size()+vars2.size() << " variables in " << time << " s" << endl;
+
   return 0;
 }
-
@@ -0,0 +1,362 @@
+#include <iostream>
+#include <fstream>
+#include <vector>
+#include <array>
+#include <string>
+#include <cstring>
+#include <cmath>
+#include <regex>
+#include <future>
+#include <atomic>
+#include <thread>
+#include <algorithm>
+#include <limits>
+#include <chrono>
+
+#include "array_ops.hh"
+#include "exception.hh"
+#include "skim_file.hh"
+#include "quantile_sketch.hh"
+
+// ROOT-free first guess binnings from a single pass over skim files
+// Signal and background of every variable are accumulated in weighted
+// quantile sketches, from which bin edges are proposed and written
+// in the .bins format
+
+using std::cout;
+using std::cerr;
+using std::endl;
+using ivanp::exception;
+
+using sketch = ivanp::quantile_sketch<double>;
+
+#define PROPOSE_VARS(F) \
+  F(pT_yy) F(yAbs_yy) F(cosTS_yy) F(pTt_yy) F(Dy_y_y) \
+  F(HT) F(HT_yy) F(pT_j1) F(pT_j2) F(pT_j3) F(yAbs_j1) F(yAbs_j2) \
+  F(Dphi_j_j) F(Dphi_j_j_signed) F(Dy_j_j) F(m_jj) \
+  F(pT_yyjj) F(Dphi_yy_jj) F(sumTau_yyj) F(maxTau_yyj) \
+  F(pT_yy_0j) F(pT_yy_1j) F(pT_yy_2j) F(pT_yy_3j) F(pT_j1_excl) \
+  F(xH) F(x1) F(x2) F(m_yyj)
+
+#define ENUM_(NAME) v_##NAME,
+#define STR_(NAME) #NAME,
+enum var_id { PROPOSE_VARS(ENUM_) nvars };
+const char* var_names[] = { PROPOSE_VARS(STR_) };
+
+struct sb_sketch {
+  // negative MC weights are sketched separately and subtracted
+  sketch sig, sig_neg, bkg;
+
+  void merge(const sb_sketch& o) {
+    sig.merge(o.sig);
+    sig_neg.merge(o.sig_neg);
+    bkg.merge(o.bkg);
+  }
+
+  inline double s(double x) const {
+    return sig.weight_below(x) - sig_neg.weight_below(x);
+  }
+  inline double b(double x) const { return bkg.weight_below(x); }
+
+  double min() const {
+    return std::min({sig.min(),sig_neg.min(),bkg.min()});
+  }
+  double max() const {
+    return std::max({sig.max(),sig_neg.max(),bkg.max()});
+  }
+};
+using sketches = std::array<sb_sketch,nvars>;
+
+void fill(const skim::reader& f, sketches& sk,
+  double lumi, double data_factor, const std::array<double,2>& myy_window
+) {
+  const float *_weight = f.column<float>("weight");
+  const uint8_t *_flags = f.column<uint8_t>("flags");
+
+#define COL_(NAME) const float *_##NAME = f.column<float>(#NAME);
+  SKIM_VARS(COL_)
+  COL_(m_yyj)
+#undef COL_
+
+  for (uint64_t i=0, n=f.nevents(); i<n; ++i) {
+    const bool is_mc = _flags[i] & skim::mc_flag;
+    const bool is_in_window = in(_m_yy[i],myy_window);
+    double w;
+    if (is_mc) { // signal from MC
+      if (!is_in_window) continue;
+      w = _weight[i] * lumi;
+    } else { // background from data
+      if (is_in_window) continue;
+      w = data_factor;
+    }
+    const auto add = [&sk,is_mc,w](var_id v, double x){
+      auto& s = sk[v];
+      if (!is_mc) s.bkg.fill(x,w);
+      else if (w > 0.) s.sig.fill(x,w);
+      else s.sig_neg.fill(x,-w);
+    };
+
+    const int nj = _N_j[i];
+    const double pT_yy = _pT_yy[i]*1e-3;
+    const double HT = _HT[i]*1e-3;
+
+    add(v_pT_yy, pT_yy);
+    add(v_yAbs_yy, _yAbs_yy[i]);
+    add(v_cosTS_yy, std::abs(_cosTS_yy[i]));
+    add(v_pTt_yy, _pTt_yy[i]*1e-3);
+    add(v_Dy_y_y, std::abs(_Dy_y_y[i]));
+    add(v_HT, HT);
+    add(v_HT_yy, HT+pT_yy);
+    add(v_xH, pT_yy/HT);
+
+    if (nj == 0) add(v_pT_yy_0j, pT_yy);
+
+    if (nj < 1) continue; // 1 jet ----------------------------------
+
+    const double pT_j1 = _pT_j1[i]*1e-3;
+    add(v_pT_j1, pT_j1);
+    add(v_yAbs_j1, _yAbs_j1[i]);
+    add(v_sumTau_yyj, _sumTau_yyj[i]*1e-3);
+    add(v_maxTau_yyj, _maxTau_yyj[i]*1e-3);
+    add(v_x1, pT_j1/HT);
+    add(v_m_yyj, _m_yyj[i]);
+
+    if (nj == 1) {
+      add(v_pT_j1_excl, pT_j1);
+      add(v_pT_yy_1j, pT_yy);
+    }
+
+    if (nj < 2) continue; // 2 jets ---------------------------------
+
+    const double pT_j2 = _pT_j2[i]*1e-3;
+    add(v_pT_j2, pT_j2);
+    add(v_yAbs_j2, _yAbs_j2[i]);
+    add(v_Dphi_yy_jj, M_PI - std::abs(_Dphi_yy_jj[i]));
+    add(v_Dphi_j_j_signed, _Dphi_j_j_signed[i]);
+    add(v_Dphi_j_j, std::abs(_Dphi_j_j[i]));
+    add(v_Dy_j_j, std::abs(_Dy_j_j[i]));
+    add(v_m_jj, _m_jj[i]*1e-3);
+    add(v_pT_yyjj, _pT_yyjj[i]*1e-3);
+    add(v_x2, pT_j2/HT);
+
+    if (nj == 2) add(v_pT_yy_2j, pT_yy);
+
+    if (nj < 3) continue; // 3 jets ---------------------------------
+
+    add(v_pT_yy_3j, pT_yy);
+    add(v_pT_j3, _pT_j3[i]*1e-3);
+  }
+}
+
+// smallest x in [a,b] for which pass(x) is true, assuming pass(b)
+template <typename F>
+double bisect(double a, double b, F pass) {
+  for (int i=0; i<60 && a<b; ++i) {
+    const double m = a + (b-a)/2;
+    if (m<=a || m>=b) break;
+    (pass(m) ? b : a) = m;
+  }
+  return b;
+}
+
+// first edge above from where pass turns true, found on the grid of
+// centroid means and refined by bisection
+template <typename F>
+double next_edge(const std::vector<double>& grid, double from, F pass) {
+  auto it = std::upper_bound(grid.begin(),grid.end(),from);
+  double prev = from;
+  for (; it!=grid.end(); prev = *it, ++it)
+    if (pass(*it)) return bisect(prev,*it,pass);
+  return std::numeric_limits<double>::quiet_NaN();
+}
+
+std::vector<double> grid(const sb_sketch& s) {
+  std::vector<double> g;
+  for (const sketch* x : {&s.sig,&s.sig_neg,&s.bkg})
+    for (const auto& c : x->centroids()) g.push_back(c.mean);
+  g.push_back(s.max());
+  std::sort(g.begin(),g.end());
+  g.erase(std::unique(g.begin(),g.end()),g.end());
+  return g;
+}
+
+// n bins with equal signal
+std::vector<double> equal_signal(const sb_sketch& s, unsigned n) {
+  const double lo = s.min(), hi = s.max(), total = s.s(hi);
+  const auto g = grid(s);
+  std::vector<double> edges { lo };
+  for (unsigned k=1; k<n; ++k) {
+    const double target = total*k/n;
+    const double e = next_edge(g,edges.back(),
+      [&](double x){ return s.s(x) >= target; });
+    if (!(e < hi)) break;
+    edges.push_back(e);
+  }
+  edges.push_back(hi);
+  return edges;
+}
+
+// as many bins as possible, each with significance of at least target,
+// scanning from below; a remainder short of the target is merged into
+// the last bin
+std::vector<double> equal_signif(const sb_sketch& s, double target) {
+  const double lo = s.min(), hi = s.max();
+  const auto g = grid(s);
+  std::vector<double> edges { lo };
+  for (;;) {
+    const double a = edges.back(), sa = s.s(a), ba = s.b(a);
+    const auto pass = [&](double x){
+      const double sig = s.s(x)-sa, spb = sig + s.b(x)-ba;
+      return spb > 0. && sig/std::sqrt(spb) >= target;
+    };
+    const double e = next_edge(g,a,pass);
+    if (!(e < hi)) {
+      if (edges.size()>1 && !pass(hi)) edges.pop_back();
+      break;
+    }
+    edges.push_back(e);
+  }
+  edges.push_back(hi);
+  return edges;
+}
+
+// round edges to 4 significant digits of the range
+// the outer edges are rounded outwards, so that all events stay inside
+void round_edges(std::vector<double>& edges) {
+  const double range = edges.back()-edges.front();
+  if (!(range > 0.)) return;
+  const double step = std::pow(10.,std::floor(std::log10(range))-3);
+  const double lo = edges.front(), hi = edges.back();
+  for (auto& e : edges) e = std::round(e/step)*step;
+  edges.front() = std::floor(lo/step)*step;
+  edges.back() = std::ceil(hi/step)*step;
+  edges.erase(std::unique(edges.begin(),edges.end()),edges.end());
+}
+
+int main(int argc, const char* argv[]) {
+  const std::array<double,2> myy_window{121e3,129e3};
+  std::array<double,2> myy_range{0,0};
+  double lumi = 0., lumi_in = 0.;
+  unsigned nbins = 10;
+  double signif = 0.; // equal signal bins if 0
+  std::string fout_name("propose.bins");
+
+  std::vector<skim::reader> skims;
+  skims.reserve(argc-1);
+
+  for (int a=1; a<argc; ++a) { // loop over arguments
+    static const std::regex skim_re(
+      "^(.*/)?.*\\.skim$", std::regex::optimize);
+    static const std::regex lumi_re(
+      "([-+]?[0-9]*\\.?[0-9]+([eE][-+]?[0-9]+)?) *i([pf])b$",
+      std::regex::optimize);
+    static const std::regex nbins_re(
+      "^nbins:([0-9]+)$", std::regex::optimize);
+    static const std::regex signif_re(
+      "^signif:([0-9]*\\.?[0-9]+([eE][-+]?[0-9]+)?)$", std::regex::optimize);
+    static const std::regex fout_re(
+      "^out:(.+\\.bins)$", std::regex::optimize);
+    std::cmatch match;
+
+    const char *arg = argv[a], *end = arg+std::strlen(arg);
+    if (std::regex_search(arg,end,match,skim_re)) {
+      skims.emplace_back(arg);
+      const auto& head = skims.back().head();
+      cout << "\033[36mSkim\033[0m: " << arg
+           << " (" << head.nevents << " events)" << endl;
+      if (skims.size()==1) {
+        myy_range = { head.myy_range[0], head.myy_range[1] };
+      } else if (myy_range[0]!=head.myy_range[0] ||
+                 myy_range[1]!=head.myy_range[1]) {
+        cerr << "skim files have different m_yy ranges" << endl;
+        return 1;
+      }
+      lumi_in += head.lumi_in;
+    } else if (std::regex_search(arg,end,match,nbins_re)) {
+      nbins = std::stoul(match[1]);
+    } else if (std::regex_search(arg,end,match,signif_re)) {
+      signif = std::stod(match[1]);
+    } else if (std::regex_search(arg,end,match,fout_re)) {
+      fout_name = match[1];
+    } else if (std::regex_search(arg,end,match,lumi_re)) {
+      lumi = std::stod(match[1]);
+      if (arg[match.position(3)]=='f') lumi *= 1e3; // femto to pico
+    } else {
+      cerr << "arg error: unrecognized argument: " << arg << endl;
+      return 1;
+    }
+  }
+  if (!skims.size()) {
+    cerr << "usage: " << argv[0]
+         << " file.skim ... [36.1ifb] [nbins:N | signif:Z] [out:file.bins]"
+         << endl;
+    return 1;
+  }
+  if (!nbins) {
+    cerr << "nbins must be positive" << endl;
+    return 1;
+  }
+  double data_factor = len(myy_window)/(len(myy_range)-len(myy_window));
+  cout << "\n\033[36mTotal data lumi\033[0m: "
+       << lumi_in << " ipb" << endl;
+  if (lumi!=0.) data_factor *= (lumi / lumi_in);
+  else lumi = lumi_in;
+  cout << "Scaling to " << lumi << " ipb" << endl;
+  if (signif > 0.)
+    cout << "\033[36mEqual significance\033[0m: " << signif << endl;
+  else
+    cout << "\033[36mEqual signal\033[0m: " << nbins << " bins" << endl;
+  cout << "\033[36mOutput file\033[0m: " << fout_name << endl << endl;
+
+  // fill sketches, one set per worker, merged at the end ============
+  const auto start = std::chrono::steady_clock::now();
+
+  const unsigned nthreads = std::min<size_t>(
+    std::max(1u,std::thread::hardware_concurrency()), skims.size());
+  std::vector<sketches> partial(nthreads);
+  std::atomic<size_t> next(0);
+  std::vector<std::future<void>> workers;
+  for (unsigned t=0; t<nthreads; ++t)
+    workers.emplace_back(std::async(std::launch::async,[&,t]{
+      for (size_t i; (i = next++) < skims.size(); )
+        fill(skims[i],partial[t],lumi,data_factor,myy_window);
+    }));
+  for (auto& w : workers) w.get(); // rethrows
+
+  sketches& sk = partial[0];
+  for (unsigned t=1; t<nthreads; ++t)
+    for (unsigned v=0; v<nvars; ++v) sk[v].merge(partial[t][v]);
+
+  // propose edges ==================================================
+  std::ofstream fout(fout_name);
+  if (!fout) throw exception("cannot write ",fout_name);
+  fout << "# proposed from quantile sketches of " << lumi << " ipb, ";
+  if (signif > 0.) fout << "significance of at least " << signif;
+  else fout << nbins << " bins with equal signal";
+  fout << " per bin\n\n";
+
+  for (unsigned v=0; v<nvars; ++v) {
+    const auto& s = sk[v];
+    if (s.sig.empty()) {
+      cout << "\033[33m" << var_names[v] << "\033[0m: no signal" << endl;
+      continue;
+    }
+    auto edges = signif > 0. ? equal_signif(s,signif) : equal_signal(s,nbins);
+    round_edges(edges);
+
+    cout << "\033[35m" << var_names[v] << "\033[0m:";
+    fout << var_names[v] << " {";
+    for (const double e : edges) {
+      cout << ' ' << e;
+      fout << ' ' << e;
+    }
+    cout << " (" << edges.size()-1 << " bins)" << endl;
+    fout << " }\n";
+  }
+
+  const auto time = std::chrono::duration<double>(
+    std::chrono::steady_clock::now() - start).count();
+  cout << "\nProposed binnings in " << time << " s" << endl;
+
+  return 0;
+}
@@ -0,0 +1,142 @@
+#ifndef IVANP_QUANTILE_SKETCH_HH
+#define IVANP_QUANTILE_SKETCH_HH
+
+#include <vector>
+#include <algorithm>
+#include <limits>
+#include <cmath>
+
+namespace ivanp {
+
+// Weighted quantile sketch (merging t-digest)
+// Values are buffered, and the buffer is merged into a sorted list of
+// centroids when it fills up. Centroid weights are limited by the
+// arcsine scale function, so there are at most about compression
+// centroids, which are smaller in the tails than in the bulk.
+// Memory does not grow with the number of values.
+// Sketches filled from separate streams can be merged.
+// Weights must be positive.
+
+template <typename T = double>
+class quantile_sketch {
+public:
+  using value_type = T;
+  struct centroid { value_type mean, weight; };
+
+private:
+  value_type _compression;
+  // centroids and buffer are merged lazily, also by const queries
+  mutable std::vector<centroid> _c, _buf;
+  size_t _buf_size;
+  value_type _total, _min, _max;
+
+  // scale function, k(q) = compression/2pi * asin(2q-1)
+  inline value_type k(value_type q) const noexcept {
+    return _compression/(2*M_PI)*std::asin(2*q-1);
+  }
+  // largest weight fraction a centroid starting at q may reach
+  inline value_type q_limit(value_type q) const noexcept {
+    const value_type k1 = k(q) + 1;
+    if (k1 >= _compression/4) return 1;
+    return (std::sin(2*M_PI*k1/_compression) + 1)/2;
+  }
+
+  void compress() const {
+    if (_buf.empty()) return;
+    _buf.insert(_buf.end(),_c.begin(),_c.end());
+    _c.clear();
+    std::sort(_buf.begin(),_buf.end(),
+      [](const centroid& a, const centroid& b){ return a.mean < b.mean; });
+
+    value_type before = 0; // weight below the current centroid
+    value_type limit = _total*q_limit(0);
+    centroid cur = _buf.front();
+    for (auto it=_buf.begin()+1; it!=_buf.end(); ++it) {
+      if (before + cur.weight + it->weight <= limit) {
+        cur.weight += it->weight;
+        cur.mean += (it->mean - cur.mean)*it->weight/cur.weight;
+      } else {
+        before += cur.weight;
+        limit = _total*q_limit(before/_total);
+        _c.push_back(cur);
+        cur = *it;
+      }
+    }
+    _c.push_back(cur);
+    _buf.clear();
+  }
+
+public:
+  quantile_sketch(value_type compression = 200)
+  : _compression(compression), _buf_size(8*size_t(compression)), _total(0),
+    _min(std::numeric_limits<value_type>::max()),
+    _max(std::numeric_limits<value_type>::lowest())
+  {
+    _buf.reserve(_buf_size);
+  }
+
+  void fill(value_type x, value_type w = 1) {
+    if (!(w > 0)) return;
+    _buf.push_back({x,w});
+    _total += w;
+    if (x < _min) _min = x;
+    if (x > _max) _max = x;
+    if (_buf.size() >= _buf_size) compress();
+  }
+
+  void merge(const quantile_sketch& o) {
+    _buf.insert(_buf.end(),o._c.begin(),o._c.end());
+    _buf.insert(_buf.end(),o._buf.begin(),o._buf.end());
+    _total += o._total;
+    if (o._min < _min) _min = o._min;
+    if (o._max > _max) _max = o._max;
+    compress();
+  }
+
+  inline value_type total() const noexcept { return _total; }
+  inline value_type min() const noexcept { return _min; }
+  inline value_type max() const noexcept { return _max; }
+  inline bool empty() const noexcept { return !(_total > 0); }
+
+  const std::vector<centroid>& centroids() const {
+    compress();
+    return _c;
+  }
+
+  // interpolated weight of values below x
+  value_type weight_below(value_type x) const {
+    compress();
+    if (_c.empty() || !(x > _min)) return 0;
+    if (!(x < _max)) return _total;
+    // a centroid's weight is taken to be centered on its mean
+    value_type w0 = 0, x0 = _min, before = 0;
+    for (const auto& c : _c) {
+      const value_type w1 = before + c.weight/2;
+      if (x < c.mean) return w0 + (w1-w0)*(x-x0)/(c.mean-x0);
+      w0 = w1;
+      x0 = c.mean;
+      before += c.weight;
+    }
+    return w0 + (_total-w0)*(x-x0)/(_max-x0);
+  }
+
+  // value below which a fraction q of the weight lies
+  value_type quantile(value_type q) const {
+    compress();
+    if (_c.empty()) return std::numeric_limits<value_type>::quiet_NaN();
+    const value_type w = q*_total;
+    value_type w0 = 0, x0 = _min, before = 0;
+    for (const auto& c : _c) {
+      const value_type w1 = before + c.weight/2;
+      if (w < w1) return x0 + (c.mean-x0)*(w-w0)/(w1-w0);
+      w0 = w1;
+      x0 = c.mean;
+      before += c.weight;
+    }
+    return _total > w0 ? x0 + (_max-x0)*(w-w0)/(_total-w0) : _max;
+  }
+};
+
+} // end namespace ivanp
+
+#endif
@@ -6,29 +6,103 @@
 #include <regex>
 #include <utility>
 #include <cctype>
+#include <algorithm>
 
 #include "exception.hh"
 
 struct re_axes::store: public
   std::vector<std::pair<std::regex,axis_type>> { };
 
+namespace {
+
+using axis_ptr = ivanp::abstract_axis<double>*;
+
+/*
+ * Axis from the text between the braces
+ *   e0 e1 e2 ...              container of edges
+ *   n: min max                uniform
+ *   n: min max log            uniform in log(x)
+ *   n: min max pow p          uniform in x^p
+ *   n1: min max n2: max2 ...  piecewise uniform, n2 bins on [max,max2), ...
+ */
+axis_ptr make_axis(const std::string& body) {
+  std::vector<std::string> tokens;
+  std::string token;
+  for (char c : body) {
+    if (isspace(c) || c==':') {
+      if (token.size()) tokens.emplace_back(std::move(token));
+      token.clear();
+      if (c==':') tokens.emplace_back(1,c);
+    } else token += c;
+  }
+  if (token.size()) tokens.emplace_back(std::move(token));
+
+  const auto num = [&](size_t i){
+    if (i>=tokens.size()) throw ivanp::exception(
+      "missing number in binning \'",body,"\'");
+    if (tokens[i]==":") throw ivanp::exception(
+      "out of place \':\' in binning \'",body,"\'");
+    return std::stod(tokens[i]);
+  };
+
+  if (std::find(tokens.begin(),tokens.end(),":")==tokens.end()) {
+    std::vector<double> edges;
+    for (size_t i=0; i<tokens.size(); ++i) edges.push_back(num(i));
+    return new ivanp::container_axis<std::vector<double>,true>(
+      std::move(edges));
+  }
+
+  if (tokens.size()<4 || tokens[1]!=":") throw ivanp::exception(
+    "out of place \':\' in binning \'",body,"\'");
+  const unsigned n = num(0);
+  const double min = num(2), max = num(3);
+  if (!n) throw ivanp::exception("zero bins in binning '",body,"'");
+
+  if (tokens.size()==4)
+    return new ivanp::uniform_axis<double,true>(n,min,max);
+
+  if (tokens[4]=="log") {
+    if (tokens.size()!=5) throw ivanp::exception(
+      "extra arguments for log axis \'",body,"\'");
+    if (!(min > 0.)) throw ivanp::exception(
+      "log axis lower edge must be positive \'",body,"\'");
+    return new ivanp::log_axis<double,true>(n,min,max);
+  }
+  if (tokens[4]=="pow") {
+    if (tokens.size()!=6) throw ivanp::exception(
+      "pow axis needs 1 exponent \'",body,"\'");
+    const double p = num(5);
+    if (!(p > 0.) || min < 0.) throw ivanp::exception(
+      "pow axis needs positive exponent and range \'",body,"\'");
+    return new ivanp::pow_axis<double,true>(n,min,max,{p});
+  }
+
+  // piecewise uniform
+  std::vector<double> bounds { min, max };
+  std::vector<unsigned> nbins { n };
+  for (size_t i=4; i<tokens.size(); i+=3) {
+    if (i+1>=tokens.size() || tokens[i+1]!=":") throw ivanp::exception(
+      "expected \'n: edge\' in binning \'",body,"\'");
+    nbins.push_back(num(i));
+    if (!nbins.back()) throw ivanp::exception(
+      "zero bins in binning '",body,"'");
+    bounds.push_back(num(i+2));
+    if (!(bounds.back() > bounds[bounds.size()-2])) throw ivanp::exception(
+      "decreasing segment edge in binning \'",body,"\'");
+  }
+  return new ivanp::piecewise_axis<double,true>(std::move(bounds),nbins);
+}
+
+} // end anonymous namespace
+
 re_axes::re_axes(const std::string& filename): _store(new store) {
 
   std::fstream f(filename);
   char c; // char buffer
   bool e = false, // expression complete
        l = false, // hit left brace
-       u = false, // uniform axis
        comment = false;
-  std::string re, num_str;
-  std::vector<double> nums;
-
-  const auto push_num = [&](){
-    if (num_str.size()!=0) {
-      nums.push_back(std::stod(num_str));
-      num_str.clear();
-    }
-  };
+  std::string re, body;
 
   while (f.get(c)) {
     if (comment) {
@@ -47,43 +121,19 @@ re_axes::re_axes(const std::string& filename): _store(new store) {
         l = true;
         while (isspace(re.back())) re.pop_back();
       }
+    } else if (c!='}') {
+      body += c;
     } else {
-      if (u && c==':') throw ivanp::exception("more than 1 \':\'");
-      if (c!='}') {
-        if (isspace(c)) {
-          push_num();
-        } else if (c==':') {
-          if ( ( num_str.size() && nums.size()==0) ||
-               (!num_str.size() && nums.size()==1) ) {
-            u = true;
-            push_num();
-          } else throw ivanp::exception("out of place \':\'");
-        } else num_str += c;
-      } else {
-        if (u && nums.size()!=3) throw ivanp::exception(
-          "more than 3 arguments for uniform axis");
-
-        using axis_ptr = ivanp::abstract_axis<double>*;
-
-        _store->emplace_back( std::piecewise_construct,
-          std::make_tuple( std::move(re),
-            std::regex::nosubs | std::regex::optimize | std::regex::extended ),
-          std::make_tuple( u
-            ? static_cast<axis_ptr>(
-                new ivanp::uniform_axis<double,true>(
-                nums[0], nums[1], nums[2]))
-            : static_cast<axis_ptr>(
-                new ivanp::container_axis<std::vector<double>,true>(
-                std::move(nums)))
-          )
-        );
-
-        if (u) nums.clear();
-
-        e = false;
-        l = false;        
-        u = false;        
-      }
+      _store->emplace_back( std::piecewise_construct,
+        std::make_tuple( std::move(re),
+          std::regex::nosubs | std::regex::optimize | std::regex::extended ),
+        std::make_tuple( make_axis(body) )
+      );
+      re.clear();
+      body.clear();
+
+      e = false;
+      l = false;
     }
   } // end while c
 
@@ -0,0 +1,216 @@
+#include <iostream>
+#include <iomanip>
+#include <vector>
+#include <array>
+#include <memory>
+#include <regex>
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <chrono>
+
+#include <TFile.h>
+#include <TH1.h>
+#include <TKey.h>
+
+#include "binner.hh"
+#include "re_axes.hh"
+#include "prtbins.hh"
+#include "exception.hh"
+
+using std::cout;
+using std::cerr;
+using std::endl;
+using ivanp::exception;
+
+struct sb_bin {
+  double
+    bkg = 0, sig = 0, // for significance
+    bkg2 = 0, sig2 = 0; // square for uncertainty
+};
+
+std::ostream& operator<<(std::ostream& o, const sb_bin& b) {
+  const double signif = b.sig/std::sqrt(b.sig+b.bkg);
+
+  const auto prec = o.precision();
+  const std::ios::fmtflags f( o.flags() );
+  o << std::fixed << std::setprecision(2)
+    << b.sig << ' ' // number of signal events
+    << std::sqrt(b.sig2) << ' ' // uncertainty
+    << b.bkg << ' ' // number of background events
+    << std::sqrt(b.bkg2) << ' ' // uncertainty
+    << signif << ' ' // significance
+    << (100*b.sig/(b.sig+b.bkg)) << '%' // s/(s+b)
+    << std::setprecision(prec);
+  o.flags( f );
+  return o;
+}
+
+using re_axis = typename re_axes::axis_type;
+using re_hist = ivanp::binner<sb_bin, std::tuple<ivanp::axis_spec<re_axis>>>;
+
+// Cumulative sums of the superfine sig and bkg histograms
+// sum[k] is the sum of ROOT bins 0 to k-1, underflow included,
+// so any range of fine bins is a difference of two elements
+class fine_sums {
+  std::vector<double> edges; // fine bin edges
+  std::vector<std::array<double,4>> sum; // sig, sig2, bkg, bkg2
+
+public:
+  fine_sums(const TH1D* sig, const TH1D* bkg)
+  : edges(sig->GetNbinsX()+1), sum(sig->GetNbinsX()+3)
+  {
+    const unsigned n = sig->GetNbinsX();
+    if (bkg->GetNbinsX()!=int(n)) throw exception(
+      "histogram ",bkg->GetName()," has ",bkg->GetNbinsX(),
+      " bins instead of expected ",n);
+    // fine bins need not be uniform
+    for (unsigned i=0; i<=n; ++i)
+      edges[i] = sig->GetXaxis()->GetBinLowEdge(i+1);
+    // files from before errors were stored have no sumw2
+    const double *s = sig->GetArray(), *b = bkg->GetArray(),
+      *s2 = sig->GetSumw2N() ? sig->GetSumw2()->GetArray() : s,
+      *b2 = bkg->GetSumw2N() ? bkg->GetSumw2()->GetArray() : b;
+    sum[0] = {0.,0.,0.,0.};
+    for (unsigned k=0; k<n+2; ++k) {
+      sum[k+1] = sum[k];
+      sum[k+1][0] += s[k];
+      sum[k+1][1] += s2[k];
+      sum[k+1][2] += b[k];
+      sum[k+1][3] += b2[k];
+    }
+  }
+
+  // index into sum of a coarse edge, rounded to the nearest fine edge
+  // exact is set false if the edge is not on a fine bin edge
+  unsigned edge(double x, bool& exact) const noexcept {
+    auto it = std::lower_bound(edges.begin(),edges.end(),x);
+    if (it==edges.end() || (it!=edges.begin() && x-*(it-1) < *it-x)) --it;
+    const double w = edges.back()-edges.front();
+    exact = std::abs(x-*it) < 1e-6*w;
+    return unsigned(it-edges.begin()) + 1;
+  }
+  inline unsigned end() const noexcept { return edges.size()+1; }
+  inline double fine_edge(unsigned k) const noexcept {
+    return edges[k-1];
+  }
+
+  sb_bin operator()(unsigned a, unsigned b) const noexcept {
+    sb_bin bin;
+    bin.sig  = sum[b][0] - sum[a][0];
+    bin.sig2 = sum[b][1] - sum[a][1];
+    bin.bkg  = sum[b][2] - sum[a][2];
+    bin.bkg2 = sum[b][3] - sum[a][3];
+    return bin;
+  }
+};
+
+int main(int argc, const char* argv[]) {
+  const char *fin_name = nullptr, *bins_file = nullptr;
+
+  for (int a=1; a<argc; ++a) { // loop over arguments
+    static const std::regex root_re(
+      "^(.*/)?.*\\.root$", std::regex::optimize);
+    static const std::regex bins_re(
+      "^(.*/)?.*\\.bins$", std::regex::optimize);
+    std::cmatch match;
+
+    const char *arg = argv[a], *end = arg+std::strlen(arg);
+    if (std::regex_search(arg,end,match,root_re)) {
+      cout << "\033[36mSuperfine\033[0m: " << arg << endl;
+      fin_name = arg;
+    } else if (std::regex_search(arg,end,match,bins_re)) {
+      cout << "\033[36mBinning\033[0m: " << arg << endl;
+      bins_file = arg;
+    } else {
+      cerr << "arg error: unrecognized argument: " << arg << endl;
+      return 1;
+    }
+  }
+  if (!fin_name || !bins_file) {
+    cerr << "usage: " << argv[0] << " superfine.root file.bins" << endl;
+    return 1;
+  }
+
+  auto fin = std::make_unique<TFile>(fin_name,"read");
+  if (fin->IsZombie()) return 1;
+
+  // collect pairs of sig and bkg histograms ========================
+  std::vector<std::pair<std::string,std::array<TH1D*,2>>> vars;
+  {
+    TIter next(fin->GetListOfKeys());
+    TKey *key;
+    while ((key = static_cast<TKey*>(next()))) {
+      const std::string name(key->GetName());
+      const auto sep = name.rfind('_');
+      if (sep==std::string::npos) continue;
+      const std::string var = name.substr(0,sep), type = name.substr(sep+1);
+      if (!(type=="sig" || type=="bkg")) continue;
+      if (std::strcmp(key->GetClassName(),"TH1D")) continue; // 1D only
+
+      auto it = std::find_if(vars.begin(),vars.end(),
+        [&var](const decltype(vars)::value_type& x){ return x.first==var; });
+      if (it==vars.end()) {
+        vars.emplace_back(var,std::array<TH1D*,2>{nullptr,nullptr});
+        it = vars.end()-1;
+      }
+      it->second[type=="sig" ? 0 : 1] = dynamic_cast<TH1D*>(key->ReadObj());
+    }
+  }
+  cout << endl;
+
+  // rebin ==========================================================
+  const auto start = std::chrono::steady_clock::now();
+
+  re_axes ra(bins_file);
+  std::vector<std::unique_ptr<re_hist>> hists;
+  std::vector<std::string> skipped;
+
+  for (const auto& var : vars) {
+    if (!var.second[0] || !var.second[1])
+      throw exception("missing histograms for variable \'",var.first,"\'");
+
+    re_axis axis;
+    try {
+      axis = ra[var.first];
+    } catch (const exception&) {
+      skipped.push_back(var.first);
+      continue;
+    }
+
+    const fine_sums sums(var.second[0],var.second[1]);
+
+    const unsigned nedges = axis.nedges();
+    std::vector<unsigned> k(nedges);
+    for (unsigned i=0; i<nedges; ++i) {
+      bool exact;
+      k[i] = sums.edge(axis.edge(i),exact);
+      if (!exact)
+        cerr << "\033[33m" << var.first << "\033[0m: edge "
+             << axis.edge(i) << " is not on a fine bin edge, using "
+             << sums.fine_edge(k[i]) << endl;
+    }
+
+    hists.emplace_back(new re_hist(var.first,axis));
+    auto& bins = hists.back()->bins();
+    bins[0] = sums(0,k[0]); // underflow
+    for (unsigned i=1; i<nedges; ++i)
+      bins[i] = sums(k[i-1],k[i]);
+    bins[nedges] = sums(k[nedges-1],sums.end()); // overflow
+  }
+
+  const auto time = std::chrono::duration<double,std::milli>(
+    std::chrono::steady_clock::now() - start).count();
+
+  for (const auto& h : re_hist::all) cout << h << endl;
+
+  if (!skipped.empty()) {
+    cout << "\033[36mNo binning for\033[0m:";
+    for (const auto& name : skipped) cout << ' ' << name;
+    cout << '\n' << endl;
+  }
+  cout << "Rebinned " << hists.size() << " variables in "
+       << std::setprecision(3) << time << " ms" << endl;
+
+  return 0;
+}
@@ -4,6 +4,8 @@
 #include <array>
 #include <memory>
 #include <regex>
+#include <algorithm>
+#include <cstring>
 #include <experimental/optional>
 
 #include <TFile.h>
@@ -11,7 +13,7 @@
 #include <TTreeReaderValue.h>
 #include <TTreeReaderArray.h>
 #include <TH1.h>
-#include <TKey.h>
+#include <TH2.h>
 #include <TLorentzVector.h>
 
 #include "binner.hh"
@@ -20,7 +22,9 @@
 #include "timed_counter.hh"
 #include "array_ops.hh"
 #include "exception.hh"
-#include "prtbins.hh"
+#include "entry_cache.hh"
+#include "catalog.hh"
+#include "mxaod_chain.hh"
 
 #define TEST(var) \
   std::cout <<"\033[36m"<< #var <<"\033[0m"<< " = " << var << std::endl;
@@ -35,118 +39,9 @@ bool is_mc, is_fiducial, is_in_window;
 // ==================================================================
 #include "truth_reco_var.hh"
 
-class mxaod {
-  TFile *ptr;
-  bool _is_mc;
-public:
-  mxaod(const char* fname, bool _is_mc)
-  : ptr(new TFile(fname,"read")), _is_mc(_is_mc) {
-    if (ptr->IsZombie()) throw ivanp::exception("cannot open file ",fname);
-  }
-  ~mxaod() { delete ptr; }
-  mxaod(const mxaod& o) = delete;
-  mxaod(mxaod&& o) noexcept: ptr(o.ptr), _is_mc(o._is_mc) { o.ptr = nullptr; }
-  inline TFile* operator->() const noexcept { return ptr; }
-  inline TFile* operator* () const noexcept { return ptr; }
-  inline bool is_mc() const noexcept { return _is_mc; }
-};
-
-struct hist_bin {
-  static double weight;
-  double
-    bkg = 0, sig = 0, // for significance
-    bkg2 = 0, sig2 = 0, // square for uncertainty
-    reco = 0, truth = 0; // for purity
-
-  void operator()(bool truth_match=true) noexcept {
-    if (is_mc) {
-      if (is_in_window) { // cut for significance
-        sig += weight;
-        sig2 += weight*weight;
-      }
-      reco += weight;
-      // is_fiducial includes mass check
-      if (is_fiducial && truth_match) truth += weight;
-    } else {
-      // alway fill data here
-      // the cut is in the event loop
-      bkg += weight;
-      bkg2 += weight*weight;
-    }
-  }
-};
-double hist_bin::weight;
-
-std::ostream& operator<<(std::ostream& o, const hist_bin& b) {
-  const double // compute significance and purity
-    signif = b.sig/std::sqrt(b.sig+b.bkg),
-    purity = b.truth/b.reco;
-
-  const auto prec = o.precision();
-  const std::ios::fmtflags f( o.flags() );
-  o << std::fixed << std::setprecision(2)
-    << b.sig << ' ' // number of signal events
-    << std::sqrt(b.sig2) << ' ' // uncertainty
-    << b.bkg << ' ' // number of background events
-    << std::sqrt(b.bkg2) << ' ' // uncertainty
-    << signif << ' ' // significance
-    << (100*b.sig/(b.sig+b.bkg)) << "% " // s/(s+b)
-    << (100*purity) << '%' // purity
-    << std::setprecision(prec);
-  o.flags( f );
-  return o;
-}
-
-template <typename... Axes>
-using hist = ivanp::binner<hist_bin,
-  std::tuple<ivanp::axis_spec<Axes>...>>;
-
-using re_axis = typename re_axes::axis_type;
-template <size_t N>
-using re_hist = ivanp::binner<hist_bin,
-  ivanp::tuple_of_same_t<ivanp::axis_spec<re_axis>,N>>;
-
-template <typename T, typename Axis>
-void fill(hist<Axis>& h, const var<T>& x, bool extra_truth_match=true) {
-  const auto bin_det = h.find_bin(x.det);
-  if (is_mc) {
-    const auto bin_truth = h.find_bin(x.truth);
-    h.fill_bin(bin_det, (bin_det == bin_truth) && extra_truth_match);
-  } else h.fill_bin(bin_det);
-}
-
-template <typename T, typename Axis>
-void fill_incl(hist<Axis>& h, const var<T>& x) {
-  const auto bin_det = h.find_bin(x.det);
-  if (is_mc) {
-    const auto bin_truth = h.find_bin(x.truth);
-    for (unsigned i=bin_det; i!=0; --i)
-      h.fill_bin(i, bin_truth >= i);
-  } else for (unsigned i=bin_det; i!=0; --i) h.fill_bin(i);
-}
-
-template <typename T1, typename T2, typename A1, typename A2>
-void fill(hist<A1,A2>& h, const var<T1>& x1, const var<T2>& x2,
-  bool extra_truth_match=true
-) {
-  const auto bin_det = h.find_bin(x1.det,x2.det);
-  if (is_mc) {
-    const auto bin_truth = h.find_bin(x1.truth,x2.truth);
-    h.fill_bin(bin_det, (bin_det == bin_truth) && extra_truth_match);
-  } else h.fill_bin(bin_det);
-}
-
-template <typename F, typename... T>
-auto apply(F f, const var<T>&... vars) -> var<decltype(f(vars.det...))> {
-  if (is_mc) return { f(vars.det...), f(vars.truth...) };
-  else return { f(vars.det...), { } };
-}
-
-// functions applied to variables
-inline double phi_pi4(double phi) noexcept {
-  phi += M_PI_4;
-  return (phi <= M_PI ? phi : phi - M_PI);
-}
+#include "signif_hist.hh"
+#include "signif_fill.hh"
+#include "bootstrap.hh"
 
 TLorentzVector PxPyPzE(const std::array<double,4>& p) noexcept {
   return { p[0]*1e-3, p[1]*1e-3, p[2]*1e-3, p[3]*1e-3 };
@@ -157,14 +52,76 @@ TLorentzVector PtEtaPhiM(const std::array<double,4>& p) noexcept {
   return p4;
 };
 
+// Write m_yy spectra of all bins as TH2D with the variable along x,
+// so that x bins are numbered as in the binner, and m_yy in GeV along y
+// Signal is scaled by sig_scale, and data by bkg_scale, with no sideband
+// factor, which depends on the window
+template <typename Hists>
+void write_myy(const Hists& hists, const std::array<double,2>& myy_range,
+  double sig_scale, double bkg_scale
+) {
+  const unsigned ny = hist_bin::myy_nbins;
+  const double ylo = myy_range[0]*1e-3, yhi = myy_range[1]*1e-3;
+  for (const auto& h : hists) {
+    const auto& ax = h->axis();
+    std::vector<double> edges(ax.nedges());
+    for (unsigned i=0; i<edges.size(); ++i) edges[i] = ax.edge(i);
+    const int nx = edges.size()-1;
+    TH2D *sig = new TH2D((h.name+"_sig_myy").c_str(),"",
+      nx,edges.data(),ny,ylo,yhi);
+    TH2D *bkg = new TH2D((h.name+"_bkg_myy").c_str(),"",
+      nx,edges.data(),ny,ylo,yhi);
+    bkg->Sumw2();
+    int i = 0;
+    for (const auto& bin : h->bins()) {
+      if (!bin.sig_myy.empty()) for (unsigned j=0; j<ny; ++j) {
+        const int k = sig->GetBin(i,j+1);
+        sig->SetBinContent(k,bin.sig_myy[j]*sig_scale);
+        bkg->SetBinContent(k,bin.bkg_myy[j]*bkg_scale);
+        bkg->SetBinError(k,std::sqrt(bin.bkg2_myy[j])*bkg_scale);
+      }
+      ++i;
+    }
+  }
+}
+
+// Readers of the variables that depend on the jet pT threshold,
+// from branches with suffix sfx, e.g. "_30"
+struct jet_vars {
+  var<TTreeReaderValue<Int_t>> N_j;
+  var<TTreeReaderValue<Float_t>>
+    HT, pT_j1, pT_j2, pT_j3, yAbs_j1, yAbs_j2,
+    Dphi_j_j, Dphi_j_j_signed, Dy_j_j, m_jj,
+    sumTau_yyj, maxTau_yyj, pT_yyjj, Dphi_yy_jj;
+
+#define VARJ_(NAME) NAME(reader, #NAME+sfx)
+  jet_vars(TTreeReader& reader, const std::string& sfx)
+  : VARJ_(N_j), VARJ_(HT),
+    VARJ_(pT_j1), VARJ_(pT_j2), VARJ_(pT_j3),
+    VARJ_(yAbs_j1), VARJ_(yAbs_j2),
+    VARJ_(Dphi_j_j), Dphi_j_j_signed(reader, "Dphi_j_j"+sfx+"_signed"),
+    VARJ_(Dy_j_j), VARJ_(m_jj),
+    VARJ_(sumTau_yyj), VARJ_(maxTau_yyj),
+    VARJ_(pT_yyjj), VARJ_(Dphi_yy_jj) { }
+#undef VARJ_
+};
+
 int main(int argc, const char* argv[]) {
   const std::array<double,2> myy_range{105e3,160e3}, myy_window{121e3,129e3};
-  double data_factor = len(myy_window)/(len(myy_range)-len(myy_window));
-  double lumi = 0., lumi_in = 0., mc_factor = 1.;
+  const double data_factor =
+    len(myy_window)/(len(myy_range)-len(myy_window));
+  double mc_factor = 1.;
+  std::vector<double> lumis; // projections, ipb
 
-  std::vector<mxaod> mxaods;
+  std::vector<std::pair<std::string,bool>> mxaods;
   mxaods.reserve(argc-1);
   const char* bins_file = nullptr;
+  std::string myy_file("signif_myy.root");
+  std::vector<std::string> jet_pts; // jet pT thresholds, GeV
+  // alternative weight branches, or one array branch ending in []
+  std::vector<std::string> weight_vars;
+  // VBF cuts to scan: m_jj >, Dy_jj >, pT_j3 <
+  std::array<std::vector<double>,3> vbf_cuts;
 
   for (int a=1; a<argc; ++a) { // loop over arguments
     // validate args and parse names of input files
@@ -175,16 +132,28 @@ int main(int argc, const char* argv[]) {
     static const std::regex bins_re(
       "^(.*/)?.*\\.bins$", std::regex::optimize);
     static const std::regex lumi_re(
-      "([-+]?[0-9]*\\.?[0-9]+([eE][-+]?[0-9]+)?) *i([pf])b$",
+      "^((?:[0-9]*\\.?[0-9]+(?:[eE][-+]?[0-9]+)?,)*"
+      "[0-9]*\\.?[0-9]+(?:[eE][-+]?[0-9]+)?) *i([pf])b$",
       std::regex::optimize);
+    static const std::regex jets_re(
+      "^jets:([0-9]+(,[0-9]+)*)$", std::regex::optimize);
+    static const std::regex vbf_re(
+      "^vbf:([0-9.,]+):([0-9.,]+):([0-9.,]+)$", std::regex::optimize);
+    static const std::regex weights_re(
+      "^weights:(.+)$", std::regex::optimize);
+    static const std::regex proc_re(
+      "^(\\w+):([0-9]*\\.?[0-9]+(?:[eE][-+]?[0-9]+)?)$", std::regex::optimize);
+    static const std::regex boot_re(
+      "^boot:([0-9]+)$", std::regex::optimize);
+    static const std::regex myy_re(
+      "^myy:([0-9]+)$", std::regex::optimize);
+    static const std::regex fout_re(
+      "^out:(.+\\.root)$", std::regex::optimize);
     std::cmatch match;
 
     const char *arg = argv[a], *end = arg+std::strlen(arg);
     if (std::regex_search(arg,end,match,data_re)) { // Data
-      const double flumi = std::stod(match[2]);
-      lumi_in += flumi;
       cout << "\033[36mData\033[0m: " << arg << endl;
-      cout << "\033[36mLumi\033[0m: " << flumi << " ipb" << endl;
       mxaods.emplace_back(arg,false);
     } else if (std::regex_search(arg,end,match,mc_re)) { // MC
       cout << "\033[36mMC\033[0m: " << arg << endl;
@@ -192,9 +161,55 @@ int main(int argc, const char* argv[]) {
     } else if (std::regex_search(arg,end,match,bins_re)) { // MC
       cout << "\033[36mBinning\033[0m: " << arg << endl;
       bins_file = arg;
+    } else if (std::regex_search(arg,end,match,jets_re)) {
+      const std::string list = match[1];
+      for (size_t p=0, q; p<list.size(); p=q+1) {
+        q = list.find(',',p);
+        if (q==std::string::npos) q = list.size();
+        jet_pts.push_back(list.substr(p,q-p));
+      }
+    } else if (std::regex_search(arg,end,match,vbf_re)) {
+      // e.g. vbf:400,600:2.8,4:25,30
+      for (unsigned c=0; c<3; ++c) {
+        const std::string list = match[c+1];
+        for (size_t p=0, q; p<list.size(); p=q+1) {
+          q = list.find(',',p);
+          if (q==std::string::npos) q = list.size();
+          vbf_cuts[c].push_back(std::stod(list.substr(p,q-p)));
+        }
+      }
+    } else if (std::regex_search(arg,end,match,boot_re)) {
+      hist_bin::n_boot = std::stoul(match[1]);
+    } else if (std::regex_search(arg,end,match,myy_re)) {
+      hist_bin::myy_nbins = std::stoul(match[1]);
+    } else if (std::regex_search(arg,end,match,fout_re)) {
+      myy_file = match[1];
+    } else if (std::regex_search(arg,end,match,weights_re)) {
+      // e.g. weights:HGamEventInfoAuxDyn.weightsPDF[]
+      //   or weights:HGamEventInfoAuxDyn.weight_up,...
+      const std::string list = match[1];
+      for (size_t p=0, q; p<list.size(); p=q+1) {
+        q = list.find(',',p);
+        if (q==std::string::npos) q = list.size();
+        weight_vars.push_back(list.substr(p,q-p));
+      }
+    } else if (!std::strcmp(arg,"procs")) {
+      hist_bin::print_procs = true;
+    } else if (std::regex_search(arg,end,match,proc_re) &&
+      std::find(proc_names,proc_names+n_proc,match.str(1))!=proc_names+n_proc
+    ) { // reweight a signal process, e.g. ttH:1.2
+      hist_bin::proc_scale[
+        std::find(proc_names,proc_names+n_proc,match.str(1))-proc_names
+      ] = std::stod(match[2]);
     } else if (std::regex_search(arg,end,match,lumi_re)) {
-      lumi = std::stod(match[1]);
-      if (arg[match.position(3)]=='f') lumi *= 1e3; // femto to pico
+      // comma separated list, e.g. 36.1,80,150ifb
+      const double unit = arg[match.position(2)]=='f' ? 1e3 : 1.;
+      const std::string list = match[1];
+      for (size_t p=0, q; p<list.size(); p=q+1) {
+        q = list.find(',',p);
+        if (q==std::string::npos) q = list.size();
+        lumis.push_back(std::stod(list.substr(p,q-p))*unit);
+      }
     } else {
       cerr << "arg error: unrecognized argument: " << arg << endl;
       return 1;
@@ -208,97 +223,147 @@ int main(int argc, const char* argv[]) {
     cerr << "Must specify at least 1 .root file" << endl;
     return 1;
   }
+  // luminosities of data files are taken from the catalog
+  const auto catalog = make_catalog(mxaods);
+  const double lumi_in = data_lumi(catalog);
   cout << "\n\033[36mTotal data lumi\033[0m: "
        << lumi_in << " ipb" << endl;
-  if (lumi!=0.) data_factor *= (lumi / lumi_in);
-  else lumi = lumi_in;
-  cout << "Scaling to " << lumi << " ipb" << endl << endl;
+  if (lumis.empty()) lumis.push_back(lumi_in);
+  if (jet_pts.empty()) jet_pts.push_back("30");
+  cout << "Scaling to";
+  for (const double lumi : lumis) cout << ' ' << lumi;
+  cout << " ipb" << endl;
+  cout << "\033[36mJet pT thresholds\033[0m:";
+  for (const auto& pt : jet_pts) cout << ' ' << pt;
+  cout << " GeV" << endl;
+  // array branch, with the number of variations known from the first event
+  const bool weights_array = weight_vars.size()==1 &&
+    weight_vars[0].size()>2 &&
+    !weight_vars[0].compare(weight_vars[0].size()-2,2,"[]");
+  if (weights_array) weight_vars[0].resize(weight_vars[0].size()-2);
+  else hist_bin::n_var = weight_vars.size();
+  if (!weight_vars.empty()) {
+    cout << "\033[36mWeight variations\033[0m:";
+    for (const auto& name : weight_vars) cout << ' ' << name;
+    if (weights_array) cout << "[]";
+    cout << endl;
+  }
+  if (hist_bin::n_boot) {
+    cout << "\033[36mBootstrap replicas\033[0m: "
+         << hist_bin::n_boot << endl;
+    hist_bin::boot_weights.resize(hist_bin::n_boot);
+  }
+  const ivanp::poisson_bootstrap bootstrap;
+  if (proc_reweighted()) {
+    cout << "\033[36mReweighted\033[0m:";
+    for (unsigned i=0; i<n_proc; ++i)
+      if (hist_bin::proc_scale[i]!=1.)
+        cout << ' ' << proc_names[i] << " x" << hist_bin::proc_scale[i];
+    cout << endl;
+    if (!weight_vars.empty())
+      cerr << "\033[33mWeight variation envelopes are not reweighted "
+              "by process\033[0m" << endl;
+    if (hist_bin::n_boot)
+      cerr << "\033[33mBootstrap deviations are not reweighted "
+              "by process\033[0m" << endl;
+  }
+  if (hist_bin::myy_nbins) {
+    cout << "\033[36mm_yy spectra\033[0m: " << hist_bin::myy_nbins
+         << " bins in " << myy_file << endl;
+  }
+  cout << endl;
 
   // Histogram definitions ==========================================
   re_axes ra(bins_file);
 #define h_(name) re_hist<1> h_##name(#name,ra[#name]);
 
-  hist<ivanp::index_axis<Int_t>>
-    h_total("total",{0,1}),
-    h_N_j_excl("N_j_excl",{0,4}),
-    h_N_j_incl("N_j_incl",{0,4}),
-    h_VBF("VBF",{1,4});
+  hist<ivanp::index_axis<Int_t>> h_total("total",{0,1});
 
   h_(pT_yy) h_(yAbs_yy) h_(cosTS_yy) h_(pTt_yy) h_(Dy_y_y)
-  h_(HT) h_(HT_yy)
-  h_(pT_j1) h_(pT_j2) h_(pT_j3)
-  h_(yAbs_j1) h_(yAbs_j2)
-  h_(Dphi_j_j) h_(Dphi_j_j_signed)
-  h_(Dy_j_j) h_(m_jj)
-  h_(pT_yyjj) h_(Dphi_yy_jj)
-  h_(sumTau_yyj) h_(maxTau_yyj)
-  h_(pT_yy_0j) h_(pT_yy_1j) h_(pT_yy_2j) h_(pT_yy_3j)
-  h_(pT_j1_excl)
-
-  h_(xH) h_(x1) h_(x2)
-
-  h_(m_yyj)
-
-  using hist2 = hist<
-    ivanp::container_axis<std::vector<double>>,
-    ivanp::container_axis<std::vector<double>> >;
-  hist2
-    h_Dphi_Dy_jj("Dphi_Dy_jj",{0.,M_PI_2,M_PI},{0.,2.,8.8}),
-    h_Dphi_pi4_Dy_jj("Dphi_pi4_Dy_jj",{0.,M_PI_2,M_PI},{0.,2.,8.8}),
-    h_cosTS_pT_yy("cosTS_pT_yy",{0.,0.5,1.},{0.,30.,120.,400.}),
-    h_pT_yy_pT_j1("pT_yy_pT_j1",{0.,30.,120.,400.},{30.,65.,400.});
-
-  for (auto& file : mxaods) { // loop over MxAODs
-    is_mc = file.is_mc();
-    cout << "\033[36m" << (is_mc ? "MC" : "Data") << "\033[0m: "
-         << file->GetName() << endl;
-
-    if (is_mc) { // MC
-      TIter next(file->GetListOfKeys());
-      TKey *key;
-      while ((key = static_cast<TKey*>(next()))) {
-        std::string name(key->GetName());
-        if (name.substr(0,8)!="CutFlow_" ||
-            name.substr(name.size()-18)!="_noDalitz_weighted") continue;
-        TH1 *h = static_cast<TH1*>(key->ReadObj());
-        cout << h->GetName() << endl;
-        const double n_all = h->GetBinContent(3);
-        cout << h->GetXaxis()->GetBinLabel(3) << " = " << n_all << endl;
-        mc_factor = lumi/n_all;
-        break;
+
+  hist2 h_cosTS_pT_yy("cosTS_pT_yy",{0.,0.5,1.},{0.,30.,120.,400.});
+
+  // one set of jet histograms per threshold,
+  // suffixed with the threshold if there are several
+  std::vector<std::unique_ptr<jet_hists>> h_jets;
+  for (const auto& pt : jet_pts)
+    h_jets.emplace_back(new jet_hists(ra, jet_pts.size()>1 ? "_"+pt : ""));
+  if (!vbf_cuts[0].empty())
+    for (auto& h : h_jets) h->VBF_grid.reset(new cut_grid(
+      {150,0.,1500.}, // m_jj, GeV
+      {90,0.,9.},     // Dy_jj
+      {20,0.,100.}    // pT_j3, GeV
+    ));
+
+  // data and MC files are read as 2 chains
+  // with branch readers bound once per chain
+  for (bool chain_is_mc : {false,true}) {
+    is_mc = chain_is_mc;
+    std::vector<const file_info*> files;
+    for (const auto& f : catalog) if (f.is_mc==is_mc) files.push_back(&f);
+    if (files.empty()) continue;
+
+    // only entries passing isPassed and myy_range
+    mxaod_chain chain(files,myy_range);
+    chain.on_file([&](const file_info& info){
+      cout << "\033[36m" << (is_mc ? "MC" : "Data") << "\033[0m: "
+           << info.name << endl;
+      if (!is_mc)
+        cout << "\033[36mLumi\033[0m: " << info.lumi << " ipb" << endl;
+      else { // MC
+        cout << info.cutflow << endl;
+        cout << "sum of weights = " << info.n_all << endl;
+        mc_factor = 1./info.n_all;
+        hist_bin::proc = signal_process(info.cutflow);
+        if (hist_bin::proc==n_proc-1)
+          hist_bin::proc = signal_process(
+            info.name.substr(info.name.rfind('/')+1));
+        cout << "process = " << proc_names[hist_bin::proc] << endl;
+        if (hist_bin::proc==n_proc-1)
+          cerr << "\033[33mno signal process recognized for "
+               << info.name << "\033[0m" << endl;
       }
-    } else { // Data
-      hist_bin::weight = data_factor;
-    }
+    });
+    // accumulate signal per ipb and raw data counts,
+    // scaled to each luminosity only for the output
+    if (!is_mc) hist_bin::weight = 1.;
 
     // read variables ===============================================
-    TTreeReader reader("CollectionTree",*file);
+    TTreeReader& reader = chain.reader();
     optional<TTreeReaderValue<Float_t>> _cs_br_fe, _weight;
     optional<TTreeReaderValue<Char_t>> _isFiducial;
+    optional<TTreeReaderArray<Float_t>> _weights_array;
+    std::vector<std::unique_ptr<TTreeReaderValue<Float_t>>> _weights;
+    optional<TTreeReaderValue<UInt_t>> _run, _channel;
+    optional<TTreeReaderValue<ULong64_t>> _event;
+    if (hist_bin::n_boot) { // replicas are seeded by run and event number
+      _run.emplace(reader,"EventInfoAux.runNumber");
+      _event.emplace(reader,"EventInfoAux.eventNumber");
+      // and MC channel number
+      if (is_mc) _channel.emplace(reader,"EventInfoAux.mcChannelNumber");
+    }
     if (is_mc) {
       _cs_br_fe.emplace(reader,"HGamEventInfoAuxDyn.crossSectionBRfilterEff");
       _weight.emplace(reader,"HGamEventInfoAuxDyn.weight");
       _isFiducial.emplace(reader,"HGamTruthEventInfoAuxDyn.isFiducial");
+      if (weights_array)
+        _weights_array.emplace(reader,weight_vars[0].c_str());
+      else for (const auto& name : weight_vars)
+        _weights.emplace_back(
+          new TTreeReaderValue<Float_t>(reader,name.c_str()));
     }
-    TTreeReaderValue<Char_t> _isPassed(reader,"HGamEventInfoAuxDyn.isPassed");
 
 #define VAR_GEN_(NAME, TYPE, STR) \
   var<TTreeReaderValue<TYPE>> _##NAME(reader, STR);
 #define VAR_(NAME) VAR_GEN_(NAME, Float_t, #NAME)
-#define VAR30_(NAME) VAR_GEN_(NAME, Float_t, #NAME "_30")
-
-    VAR_GEN_(N_j, Int_t, "N_j_30")
 
     VAR_(m_yy) VAR_(pT_yy) VAR_(yAbs_yy) VAR_(cosTS_yy) VAR_(pTt_yy)
     VAR_(Dy_y_y)
 
-    VAR30_(HT)
-    VAR30_(pT_j1)      VAR30_(pT_j2)      VAR30_(pT_j3)
-    VAR30_(yAbs_j1)    VAR30_(yAbs_j2)
-    VAR30_(Dphi_j_j)   VAR_GEN_(Dphi_j_j_signed,Float_t,"Dphi_j_j_30_signed")
-    VAR30_(Dy_j_j)     VAR30_(m_jj)
-    VAR30_(sumTau_yyj) VAR30_(maxTau_yyj)
-    VAR30_(pT_yyjj)    VAR30_(Dphi_yy_jj)
+    // jet variables for every threshold, bound in the same pass
+    std::vector<std::unique_ptr<jet_vars>> jets;
+    for (const auto& pt : jet_pts)
+      jets.emplace_back(new jet_vars(reader,"_"+pt));
 
     // Get 4-momenta for photons and jets
     var<std::array<TTreeReaderArray<float>,4>>
@@ -312,28 +377,48 @@ int main(int argc, const char* argv[]) {
     // LOOP over events =============================================
     // reader.SetEntry(365022);
     using tc = ivanp::timed_counter<Long64_t>;
-    for (tc ent(reader.GetEntries(true)); reader.Next(); ++ent) {
+    for (tc ent(chain.entries()); chain.next(); ++ent) {
 
-      // selection cut
-      if (!*_isPassed) continue;
-
-      // diphoton mass cut
+      // isPassed and myy_range cuts are applied by the entry list
       const auto m_yy = *_m_yy;
-      if (!in(m_yy.det,myy_range)) continue;
 
       is_in_window = in(m_yy.det,myy_window);
+      if (hist_bin::myy_nbins)
+        hist_bin::myy_bin = std::min<unsigned>(hist_bin::myy_nbins-1,
+          hist_bin::myy_nbins*(m_yy.det-myy_range[0])/len(myy_range));
 
       if (is_mc) { // signal from MC
         hist_bin::weight = (**_weight) * (**_cs_br_fe) * mc_factor;
         is_fiducial = **_isFiducial && in(m_yy.truth,myy_range);
+        if (!weight_vars.empty()) {
+          // alternative weights replace HGamEventInfoAuxDyn.weight
+          const double factor = (**_cs_br_fe) * mc_factor;
+          if (weights_array) {
+            const unsigned n = _weights_array->GetSize();
+            if (!hist_bin::n_var) hist_bin::n_var = n;
+            else if (n!=hist_bin::n_var) throw ivanp::exception(
+              "number of weight variations changed from ",
+              hist_bin::n_var," to ",n);
+            hist_bin::var_weights.resize(n);
+            for (unsigned k=0; k<n; ++k)
+              hist_bin::var_weights[k] = (*_weights_array)[k] * factor;
+          } else {
+            hist_bin::var_weights.resize(_weights.size());
+            for (unsigned k=0; k<_weights.size(); ++k)
+              hist_bin::var_weights[k] = (**_weights[k]) * factor;
+          }
+        }
       } else { // background from data
         if (is_in_window) continue;
       }
 
-      // FILL HISTOGRAMS ============================================
+      if (hist_bin::n_boot)
+        bootstrap( is_mc
+          ? ivanp::poisson_bootstrap::key(**_channel,**_run,**_event)
+          : ivanp::poisson_bootstrap::key(**_run,**_event),
+          hist_bin::n_boot, hist_bin::boot_weights.data());
 
-      const auto nj = *_N_j;
-      bool match_truth_nj;
+      // FILL HISTOGRAMS ============================================
 
       const auto pT_yy = _pT_yy*1e-3;
       const auto yAbs_yy = *_yAbs_yy;
@@ -350,126 +435,65 @@ int main(int argc, const char* argv[]) {
       fill(h_pTt_yy, _pTt_yy*1e-3);
       fill(h_cosTS_pT_yy, cosTS_yy, pT_yy);
 
-      fill(h_N_j_excl, nj);
-      fill_incl(h_N_j_incl, nj);
-
-      const auto HT = _HT*1e-3;
-      fill(h_HT, HT);
-      fill(h_HT_yy, HT+pT_yy);
-      fill(h_xH, pT_yy/HT);
-
-      if (nj == 0) fill(h_pT_yy_0j, pT_yy, nj.truth==0);
-
-      if (nj < 1) continue; // 1 jet --------------------------------
-
-      match_truth_nj = nj.truth>=1;
+      // the leading jet does not depend on the threshold
+      auto yyj  = (_jets   [0] | PtEtaPhiM);
+           yyj += (_photons[0] | std::make_pair(PtEtaPhiM,PxPyPzE));
+           yyj += (_photons[1] | std::make_pair(PtEtaPhiM,PxPyPzE));
+      const auto m_yyj = yyj|[](auto& x){ return x.M(); };
 
-      const auto pT_j1 = _pT_j1*1e-3;
-
-      fill(h_pT_j1, pT_j1, match_truth_nj);
-
-      fill(h_yAbs_j1, *_yAbs_j1, match_truth_nj);
-
-      fill(h_sumTau_yyj, _sumTau_yyj*1e-3, match_truth_nj);
-      fill(h_maxTau_yyj, _maxTau_yyj*1e-3, match_truth_nj);
-
-      fill(h_pT_yy_pT_j1, pT_yy, pT_j1, match_truth_nj);
-
-      fill(h_x1, pT_j1/HT);
+      for (size_t i=0; i<jets.size(); ++i)
+        fill_jets(*jets[i], *h_jets[i], pT_yy, m_yyj);
+    }
+  }
 
-      if (nj == 1) {
-        match_truth_nj = nj.truth==1;
-        fill(h_pT_j1_excl, pT_j1, match_truth_nj);
-        fill(h_pT_yy_1j, pT_yy, match_truth_nj);
+  for (const double lumi : lumis) {
+    hist_bin::sig_scale = lumi;
+    hist_bin::bkg_scale = data_factor * lumi / lumi_in;
+    if (lumis.size()>1)
+      cout << "\n\033[36mLumi\033[0m: " << lumi << " ipb\n" << endl;
+    for (const auto& h : hist<ivanp::index_axis<Int_t>>::all) cout << h << endl;
+    for (const auto& h : re_hist<1>::all) cout << h << endl;
+    for (const auto& h : hist2::all) cout << h << endl;
+
+    if (!vbf_cuts[0].empty()) for (size_t i=0; i<h_jets.size(); ++i) {
+      // every combination of cuts is read from the cumulative grid
+      auto& grid = *h_jets[i]->VBF_grid;
+      grid.accumulate();
+      cout << "\033[36mVBF cuts\033[0m";
+      if (jet_pts.size()>1) cout << " (" << jet_pts[i] << " GeV jets)";
+      cout << endl;
+      for (double m_jj : vbf_cuts[0])
+      for (double dy_jj : vbf_cuts[1])
+      for (double pT_j3 : vbf_cuts[2]) {
+        const unsigned e[3] {
+          grid.edge(0,m_jj), grid.edge(1,dy_jj), grid.edge(2,pT_j3) };
+        cout << "m_jj>" << grid.axis(0).edge(e[0])
+             << " Dy_jj>" << grid.axis(1).edge(e[1])
+             << " pT_j3<" << grid.axis(2).edge(e[2])
+             << ": " << grid(e[0],e[1],e[2]) << endl;
       }
-
-      // try {
-        auto yyj  = (_jets   [0] | PtEtaPhiM);
-             yyj += (_photons[0] | std::make_pair(PtEtaPhiM,PxPyPzE));
-             yyj += (_photons[1] | std::make_pair(PtEtaPhiM,PxPyPzE));
-
-        fill(h_m_yyj, yyj|[](auto& x){ return x.M(); }, match_truth_nj);
-
-      // } catch (const std::exception& e) {
-      //   cerr << "\033[31m" << reader.GetCurrentEntry() << "\033[0m: "
-      //        << e.what() << endl;
-      // }
-
-      // if (std::abs(std::log10(jet1.Pt()/pT_j1.det))>1e-10) {
-      //   TEST( jet1.Pt() )
-      //   TEST( pT_j1.det )
-      //   for (auto pt : jet_pt) TEST(pt);
-      //   if (++cnt == 10) return 1;
-      // }
-      // if (std::abs(std::log10(higgs.Pt()/pT_yy.det))>1e-7) {
-      //   TEST( std::abs(std::log10(higgs.Pt()/pT_yy.det)) )
-      //   TEST( higgs.Pt() )
-      //   TEST( pT_yy.det )
-      //   if (++cnt == 10) return 1;
-      // }
-
-      if (nj < 2) continue; // 2 jets -------------------------------
-
-      match_truth_nj = nj.truth>=2;
-
-      const auto pT_j2   = _pT_j2*1e-3;
-      const auto dphi_jj = abs(*_Dphi_j_j);
-      const auto   dy_jj = abs(*_Dy_j_j);
-      const auto    m_jj = _m_jj*1e-3;
-
-      fill(h_pT_j2, pT_j2, match_truth_nj);
-      fill(h_yAbs_j2, *_yAbs_j2, match_truth_nj);
-
-      fill(h_Dphi_yy_jj, _Dphi_yy_jj|[](auto x){ return M_PI - std::abs(x);},
-        match_truth_nj);
-
-      fill(h_Dphi_j_j_signed, *_Dphi_j_j_signed, match_truth_nj);
-      fill(h_Dphi_j_j, dphi_jj, match_truth_nj);
-      fill(h_Dy_j_j, dy_jj, match_truth_nj);
-      fill(h_m_jj, m_jj, match_truth_nj);
-
-      fill(h_pT_yyjj, _pT_yyjj*1e-3, match_truth_nj);
-
-      fill(h_Dphi_Dy_jj, dphi_jj, dy_jj, match_truth_nj);
-      fill(h_Dphi_pi4_Dy_jj, dphi_jj|phi_pi4, dy_jj, match_truth_nj);
-
-      fill(h_x2, pT_j2/HT);
-
-      if (nj == 2) fill(h_pT_yy_2j, pT_yy, nj.truth==2);
-
-      // VBF --------------------------------------------------------
-      var<double> pT_j3{0.,0.};
-      if (nj > 2) pT_j3 = _pT_j3*1e-3;
-
-      auto VBF1 = apply([](double m_jj, double dy_jj, double pT_j3) {
-        return (m_jj > 600.) && (dy_jj > 4.0) && (pT_j3 < 30.);
-      }, m_jj, dy_jj, pT_j3);
-      auto VBF2 = apply([](double m_jj, double dy_jj, double pT_j3) {
-        return (m_jj > 600.) && (dy_jj > 4.0) && (pT_j3 < 25.);
-      }, m_jj, dy_jj, pT_j3);
-      auto VBF3 = apply([](double m_jj, double dy_jj, double pT_j3) {
-        return (m_jj > 400.) && (dy_jj > 2.8) && (pT_j3 < 30.);
-      }, m_jj, dy_jj, pT_j3);
-
-      if (VBF1.det) h_VBF.fill_bin(1,VBF1.det==VBF1.truth);
-      if (VBF2.det) h_VBF.fill_bin(2,VBF2.det==VBF2.truth);
-      if (VBF3.det) h_VBF.fill_bin(3,VBF3.det==VBF3.truth);
-      // ------------------------------------------------------------
-
-      if (nj < 3) continue; // 3 jets -------------------------------
-
-      match_truth_nj = nj.truth>=3;
-
-      fill(h_pT_yy_3j, pT_yy, match_truth_nj);
-      fill(h_pT_j3, pT_j3, match_truth_nj);
+      cout << endl;
     }
-
-    file->Close();
   }
 
-  for (const auto& h : hist<ivanp::index_axis<Int_t>>::all) cout << h << endl;
-  for (const auto& h : re_hist<1>::all) cout << h << endl;
-  for (const auto& h : hist2::all) cout << h << endl;
+  if (hist_bin::myy_nbins) {
+    auto fout = std::make_unique<TFile>(myy_file.c_str(),"recreate");
+    if (fout->IsZombie()) return 1;
+    // m_yy bins overlapping the window, where data were not read
+    TH1D *blinded = new TH1D("myy_blinded","",hist_bin::myy_nbins,
+      myy_range[0]*1e-3,myy_range[1]*1e-3);
+    for (unsigned j=1; j<=hist_bin::myy_nbins; ++j)
+      if (blinded->GetBinLowEdge(j+1) > myy_window[0]*1e-3 &&
+          blinded->GetBinLowEdge(j) < myy_window[1]*1e-3)
+        blinded->SetBinContent(j,1);
+    // scaled to the first luminosity
+    const double sig_scale = lumis.front(),
+                 bkg_scale = lumis.front() / lumi_in;
+    write_myy(hist<ivanp::index_axis<Int_t>>::all,myy_range,
+      sig_scale,bkg_scale);
+    write_myy(re_hist<1>::all,myy_range,sig_scale,bkg_scale);
+    fout->Write();
+  }
 
   return 0;
 }
@@ -0,0 +1,156 @@
+#ifndef SIGNIF_FILL_HH
+#define SIGNIF_FILL_HH
+
+// Histograms and fill code shared by signif and fast_signif
+// Requires signif_hist.hh to be included first
+
+#include <string>
+#include <memory>
+
+#include "cut_grid.hh"
+
+using hist2 = hist<
+  ivanp::container_axis<std::vector<double>>,
+  ivanp::container_axis<std::vector<double>> >;
+
+// Histograms of the variables that depend on the jet pT threshold
+// Names get suffix sfx, binnings are looked up without it
+struct jet_hists {
+  hist<ivanp::index_axis<int>> N_j_excl, N_j_incl, VBF;
+  re_hist<1>
+    HT, HT_yy, pT_j1, pT_j2, pT_j3, yAbs_j1, yAbs_j2,
+    Dphi_j_j, Dphi_j_j_signed, Dy_j_j, m_jj, pT_yyjj, Dphi_yy_jj,
+    sumTau_yyj, maxTau_yyj, pT_yy_0j, pT_yy_1j, pT_yy_2j, pT_yy_3j,
+    pT_j1_excl, xH, x1, x2, m_yyj;
+  hist2 Dphi_Dy_jj, Dphi_pi4_Dy_jj, pT_yy_pT_j1;
+  // m_jj, Dy_jj, pT_j3 for the VBF cut scan, if requested
+  std::unique_ptr<cut_grid> VBF_grid;
+
+#define h_(NAME) NAME(#NAME+sfx, ra[#NAME])
+  jet_hists(const re_axes& ra, const std::string& sfx)
+  : N_j_excl("N_j_excl"+sfx,{0,4}),
+    N_j_incl("N_j_incl"+sfx,{0,4}),
+    VBF("VBF"+sfx,{1,4}),
+    h_(HT), h_(HT_yy),
+    h_(pT_j1), h_(pT_j2), h_(pT_j3),
+    h_(yAbs_j1), h_(yAbs_j2),
+    h_(Dphi_j_j), h_(Dphi_j_j_signed),
+    h_(Dy_j_j), h_(m_jj),
+    h_(pT_yyjj), h_(Dphi_yy_jj),
+    h_(sumTau_yyj), h_(maxTau_yyj),
+    h_(pT_yy_0j), h_(pT_yy_1j), h_(pT_yy_2j), h_(pT_yy_3j),
+    h_(pT_j1_excl),
+    h_(xH), h_(x1), h_(x2),
+    h_(m_yyj),
+    Dphi_Dy_jj("Dphi_Dy_jj"+sfx,{0.,M_PI_2,M_PI},{0.,2.,8.8}),
+    Dphi_pi4_Dy_jj("Dphi_pi4_Dy_jj"+sfx,{0.,M_PI_2,M_PI},{0.,2.,8.8}),
+    pT_yy_pT_j1("pT_yy_pT_j1"+sfx,{0.,30.,120.,400.},{30.,65.,400.}) { }
+#undef h_
+};
+
+// Fill histograms of one jet pT threshold
+// Jets is any type with members named as the jet variables,
+// dereferenced to the var of the current event
+// Variables that do not depend on jets are computed once per event
+template <typename Jets>
+void fill_jets(Jets& v, jet_hists& h,
+  const var<double>& pT_yy, const var<double>& m_yyj
+) {
+  const auto nj = *v.N_j;
+  bool match_truth_nj;
+
+  fill(h.N_j_excl, nj);
+  fill_incl(h.N_j_incl, nj);
+
+  const auto HT = *v.HT*1e-3;
+  fill(h.HT, HT);
+  fill(h.HT_yy, HT+pT_yy);
+  fill(h.xH, pT_yy/HT);
+
+  if (nj == 0) fill(h.pT_yy_0j, pT_yy, nj.truth==0);
+
+  if (nj < 1) return; // 1 jet ----------------------------------------
+
+  match_truth_nj = nj.truth>=1;
+
+  const auto pT_j1 = *v.pT_j1*1e-3;
+
+  fill(h.pT_j1, pT_j1, match_truth_nj);
+
+  fill(h.yAbs_j1, *v.yAbs_j1, match_truth_nj);
+
+  fill(h.sumTau_yyj, *v.sumTau_yyj*1e-3, match_truth_nj);
+  fill(h.maxTau_yyj, *v.maxTau_yyj*1e-3, match_truth_nj);
+
+  fill(h.pT_yy_pT_j1, pT_yy, pT_j1, match_truth_nj);
+
+  fill(h.x1, pT_j1/HT);
+
+  if (nj == 1) {
+    match_truth_nj = nj.truth==1;
+    fill(h.pT_j1_excl, pT_j1, match_truth_nj);
+    fill(h.pT_yy_1j, pT_yy, match_truth_nj);
+  }
+
+  fill(h.m_yyj, m_yyj, match_truth_nj);
+
+  if (nj < 2) return; // 2 jets ---------------------------------------
+
+  match_truth_nj = nj.truth>=2;
+
+  const auto pT_j2   = *v.pT_j2*1e-3;
+  const auto dphi_jj = abs(*v.Dphi_j_j);
+  const auto   dy_jj = abs(*v.Dy_j_j);
+  const auto    m_jj = *v.m_jj*1e-3;
+
+  fill(h.pT_j2, pT_j2, match_truth_nj);
+  fill(h.yAbs_j2, *v.yAbs_j2, match_truth_nj);
+
+  fill(h.Dphi_yy_jj,
+    (*v.Dphi_yy_jj)|[](auto x){ return M_PI - std::abs(x);},
+    match_truth_nj);
+
+  fill(h.Dphi_j_j_signed, *v.Dphi_j_j_signed, match_truth_nj);
+  fill(h.Dphi_j_j, dphi_jj, match_truth_nj);
+  fill(h.Dy_j_j, dy_jj, match_truth_nj);
+  fill(h.m_jj, m_jj, match_truth_nj);
+
+  fill(h.pT_yyjj, *v.pT_yyjj*1e-3, match_truth_nj);
+
+  fill(h.Dphi_Dy_jj, dphi_jj, dy_jj, match_truth_nj);
+  fill(h.Dphi_pi4_Dy_jj, dphi_jj|phi_pi4, dy_jj, match_truth_nj);
+
+  fill(h.x2, pT_j2/HT);
+
+  if (nj == 2) fill(h.pT_yy_2j, pT_yy, nj.truth==2);
+
+  // VBF ----------------------------------------------------------------
+  var<double> pT_j3{0.,0.};
+  if (nj > 2) pT_j3 = *v.pT_j3*1e-3;
+
+  auto VBF1 = apply([](double m_jj, double dy_jj, double pT_j3) {
+    return (m_jj > 600.) && (dy_jj > 4.0) && (pT_j3 < 30.);
+  }, m_jj, dy_jj, pT_j3);
+  auto VBF2 = apply([](double m_jj, double dy_jj, double pT_j3) {
+    return (m_jj > 600.) && (dy_jj > 4.0) && (pT_j3 < 25.);
+  }, m_jj, dy_jj, pT_j3);
+  auto VBF3 = apply([](double m_jj, double dy_jj, double pT_j3) {
+    return (m_jj > 400.) && (dy_jj > 2.8) && (pT_j3 < 30.);
+  }, m_jj, dy_jj, pT_j3);
+
+  if (VBF1.det) h.VBF.fill_bin(1,VBF1.det==VBF1.truth);
+  if (VBF2.det) h.VBF.fill_bin(2,VBF2.det==VBF2.truth);
+  if (VBF3.det) h.VBF.fill_bin(3,VBF3.det==VBF3.truth);
+
+  if (h.VBF_grid) (*h.VBF_grid)(m_jj, dy_jj, pT_j3, match_truth_nj);
+  // --------------------------------------------------------------------
+
+  if (nj < 3) return; // 3 jets ---------------------------------------
+
+  match_truth_nj = nj.truth>=3;
+
+  fill(h.pT_yy_3j, pT_yy, match_truth_nj);
+  fill(h.pT_j3, pT_j3, match_truth_nj);
+}
+
+#endif
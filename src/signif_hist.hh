@@ -0,0 +1,322 @@
+#ifndef SIGNIF_HIST_HH
+#define SIGNIF_HIST_HH
+
+// Histogram bins and fill functions shared by signif and fast_signif
+// Requires global variables
+//   bool is_mc, is_fiducial, is_in_window;
+// and var<T> from truth_reco_var.hh to be declared before inclusion
+// Defines hist_bin::weight, so include in only one translation unit
+
+#include <iostream>
+#include <iomanip>
+#include <vector>
+#include <array>
+#include <algorithm>
+#include <string>
+#include <utility>
+#include <cmath>
+#include <cctype>
+
+#include "binner.hh"
+#include "re_axes.hh"
+#include "prtbins.hh"
+
+// Signal production processes
+// MC files are assigned a process by signal_process()
+constexpr unsigned n_proc = 9;
+constexpr const char* proc_names[n_proc] = {
+  "ggH", "VBF", "WH", "ZH", "ggZH", "ttH", "bbH", "tH", "other"
+};
+
+// Process of an MC sample from its CutFlow histogram or file name
+// The name is split into tokens at '_', '.' and '/', and the letters
+// of each token before the mass, e.g. WmH in WmH125J, are matched
+// exactly, so that e.g. tWH is not taken for WH
+unsigned signal_process(const std::string& name) {
+  static const std::pair<const char*,unsigned> tokens[] = {
+    {"ggH",0}, {"VBFH",1}, {"VBF",1},
+    {"WH",2}, {"WmH",2}, {"WpH",2},
+    {"ZH",3}, {"qqZH",3}, {"ggZH",4},
+    {"ttH",5}, {"bbH",6},
+    {"tH",7}, {"tWH",7}, {"tHW",7}, {"tHq",7}, {"tHjb",7}
+  };
+  for (size_t p=0, q; p<name.size(); p=q+1) {
+    q = name.find_first_of("_./",p);
+    if (q==std::string::npos) q = name.size();
+    size_t l = p;
+    while (l<q && std::isalpha(name[l])) ++l;
+    const std::string tok = name.substr(p,l-p);
+    for (const auto& t : tokens)
+      if (tok==t.first) return t.second;
+  }
+  return n_proc-1;
+}
+
+struct hist_bin {
+  static double weight;
+  // applied when printing, so that one fill can be reported
+  // for several luminosities
+  static double sig_scale, bkg_scale;
+  // m_yy spectra, only kept if myy_nbins is not 0
+  static unsigned myy_nbins, myy_bin; // m_yy bin of the current event
+  // process of the current event, and factors by which
+  // processes are reweighted when printing
+  static unsigned proc;
+  static std::array<double,n_proc> proc_scale;
+  static bool print_procs; // print fraction of signal from each process
+  // alternative weights of the current MC event, for systematics
+  // only kept if n_var is not 0
+  static unsigned n_var;
+  static std::vector<double> var_weights;
+  // Poisson weights of the current event for bootstrap replicas
+  // only kept if n_boot is not 0
+  static unsigned n_boot;
+  static std::vector<double> boot_weights;
+
+  double
+    bkg = 0, sig = 0, // for significance
+    bkg2 = 0, sig2 = 0, // square for uncertainty
+    reco = 0, truth = 0; // for purity
+  // sig, sig2, reco, truth of each process
+  std::array<std::array<double,4>,n_proc> procs { };
+  // signal and data weight, and data sum of squares, in bins of m_yy
+  std::vector<double> sig_myy, bkg_myy, bkg2_myy;
+  // sig, reco and truth for each weight variation, n_var of each
+  std::vector<double> vars;
+  // sig, bkg, reco and truth for each bootstrap replica, n_boot of each
+  std::vector<double> boot;
+
+  void operator()(bool truth_match=true) {
+    if (is_mc) {
+      auto& p = procs[proc];
+      if (is_in_window) { // cut for significance
+        sig += weight;
+        sig2 += weight*weight;
+        p[0] += weight;
+        p[1] += weight*weight;
+      }
+      reco += weight;
+      p[2] += weight;
+      // is_fiducial includes mass check
+      if (is_fiducial && truth_match) {
+        truth += weight;
+        p[3] += weight;
+      }
+      if (n_var) fill_vars(truth_match);
+    } else {
+      // alway fill data here
+      // the cut is in the event loop
+      bkg += weight;
+      bkg2 += weight*weight;
+    }
+    if (n_boot) fill_boot(truth_match);
+    if (myy_nbins) fill_myy();
+  }
+
+private:
+  // all variations are added to one contiguous block of the bin
+  void fill_vars(bool truth_match) {
+    if (vars.empty()) vars.assign(3*n_var,0.);
+    const double *w = var_weights.data();
+    double *v = vars.data();
+    if (is_in_window)
+      for (unsigned k=0; k<n_var; ++k) v[k] += w[k];
+    v += n_var;
+    for (unsigned k=0; k<n_var; ++k) v[k] += w[k];
+    v += n_var;
+    if (is_fiducial && truth_match)
+      for (unsigned k=0; k<n_var; ++k) v[k] += w[k];
+  }
+
+  void fill_boot(bool truth_match) {
+    if (boot.empty()) boot.assign(4*n_boot,0.);
+    const double *r = boot_weights.data();
+    double *v = boot.data();
+    if (is_mc) {
+      if (is_in_window)
+        for (unsigned k=0; k<n_boot; ++k) v[k] += weight*r[k];
+      v += 2*n_boot;
+      for (unsigned k=0; k<n_boot; ++k) v[k] += weight*r[k];
+      v += n_boot;
+      if (is_fiducial && truth_match)
+        for (unsigned k=0; k<n_boot; ++k) v[k] += weight*r[k];
+    } else {
+      v += n_boot;
+      for (unsigned k=0; k<n_boot; ++k) v[k] += weight*r[k];
+    }
+  }
+
+  void fill_myy() {
+    if (sig_myy.empty()) {
+      sig_myy.assign(myy_nbins,0.);
+      bkg_myy.assign(myy_nbins,0.);
+      bkg2_myy.assign(myy_nbins,0.);
+    }
+    if (is_mc) sig_myy[myy_bin] += weight;
+    else {
+      bkg_myy[myy_bin] += weight;
+      bkg2_myy[myy_bin] += weight*weight;
+    }
+  }
+};
+double hist_bin::weight;
+double hist_bin::sig_scale = 1, hist_bin::bkg_scale = 1;
+unsigned hist_bin::myy_nbins = 0, hist_bin::myy_bin;
+unsigned hist_bin::proc = n_proc-1;
+std::array<double,n_proc> hist_bin::proc_scale {1,1,1,1,1,1,1,1,1};
+bool hist_bin::print_procs = false;
+unsigned hist_bin::n_var = 0;
+std::vector<double> hist_bin::var_weights;
+unsigned hist_bin::n_boot = 0;
+std::vector<double> hist_bin::boot_weights;
+
+// are any processes reweighted
+bool proc_reweighted() noexcept {
+  for (const double f : hist_bin::proc_scale) if (f!=1.) return true;
+  return false;
+}
+
+std::ostream& operator<<(std::ostream& o, const hist_bin& b) {
+  double sig = b.sig, sig2 = b.sig2, reco = b.reco, truth = b.truth;
+  if (proc_reweighted()) {
+    sig = sig2 = reco = truth = 0;
+    for (unsigned i=0; i<n_proc; ++i) {
+      const double f = hist_bin::proc_scale[i];
+      const auto& p = b.procs[i];
+      sig += p[0]*f;
+      sig2 += p[1]*f*f;
+      reco += p[2]*f;
+      truth += p[3]*f;
+    }
+  }
+  sig *= hist_bin::sig_scale;
+  const double bkg = b.bkg*hist_bin::bkg_scale;
+  const double // compute significance and purity
+    signif = sig/std::sqrt(sig+bkg),
+    purity = truth/reco;
+
+  const auto prec = o.precision();
+  const std::ios::fmtflags f( o.flags() );
+  o << std::fixed << std::setprecision(2)
+    << sig << ' ' // number of signal events
+    << std::sqrt(sig2)*hist_bin::sig_scale << ' ' // uncertainty
+    << bkg << ' ' // number of background events
+    << std::sqrt(b.bkg2)*hist_bin::bkg_scale << ' ' // uncertainty
+    << signif << ' ' // significance
+    << (100*sig/(sig+bkg)) << "% " // s/(s+b)
+    << (100*purity) << '%'; // purity
+  if (hist_bin::print_procs && sig > 0) {
+    o << std::setprecision(0) << " \033[2m";
+    for (unsigned i=0; i<n_proc; ++i) {
+      const double x =
+        b.procs[i][0]*hist_bin::proc_scale[i]*hist_bin::sig_scale;
+      if (x > 0) o << ' ' << proc_names[i] << ' ' << (100*x/sig) << '%';
+    }
+    o << "\033[0m";
+  }
+  if (!b.vars.empty() && b.sig > 0 && b.reco > 0) {
+    // envelope of the relative change of signal and purity
+    const unsigned n = hist_bin::n_var;
+    const double *v = b.vars.data();
+    // purity only if it is not 0, and for variations with reco weight
+    double sig_min = 0, sig_max = 0, pur_min = 0, pur_max = 0;
+    const bool pur = b.truth > 0;
+    for (unsigned k=0; k<n; ++k) {
+      const double ds = v[k]/b.sig - 1;
+      if (ds < sig_min) sig_min = ds;
+      if (ds > sig_max) sig_max = ds;
+      if (!pur || !(v[n+k] > 0)) continue;
+      const double dp = (v[2*n+k]/v[n+k])/(b.truth/b.reco) - 1;
+      if (dp < pur_min) pur_min = dp;
+      if (dp > pur_max) pur_max = dp;
+    }
+    o << std::setprecision(1) << " \033[2msyst +" << 100*sig_max << '/'
+      << 100*sig_min << '%';
+    if (pur)
+      o << " purity +" << 100*pur_max << '/' << 100*pur_min << '%';
+    o << "\033[0m";
+  }
+  if (!b.boot.empty()) {
+    // standard deviations of significance and purity over replicas
+    const unsigned n = hist_bin::n_boot;
+    const double *v = b.boot.data();
+    // replicas with no events in the bin have 0 significance, but no
+    // purity, so they are skipped only for purity
+    double z1 = 0, z2 = 0, p1 = 0, p2 = 0;
+    unsigned np = 0;
+    for (unsigned k=0; k<n; ++k) {
+      const double
+        s = v[k]*hist_bin::sig_scale,
+        sb = s + v[n+k]*hist_bin::bkg_scale;
+      if (sb > 0) {
+        const double z = s/std::sqrt(sb);
+        z1 += z; z2 += z*z;
+      }
+      if (v[2*n+k] > 0) {
+        const double p = v[3*n+k]/v[2*n+k];
+        p1 += p; p2 += p*p; ++np;
+      }
+    }
+    z1 /= n; z2 /= n;
+    if (np) { p1 /= np; p2 /= np; }
+    o << std::setprecision(2) << " \033[2mboot "
+      << std::sqrt(std::max(z2 - z1*z1,0.)) << ' '
+      << 100*std::sqrt(std::max(p2 - p1*p1,0.)) << "%\033[0m";
+  }
+  o << std::setprecision(prec);
+  o.flags( f );
+  return o;
+}
+
+template <typename... Axes>
+using hist = ivanp::binner<hist_bin,
+  std::tuple<ivanp::axis_spec<Axes>...>>;
+
+using re_axis = typename re_axes::axis_type;
+template <size_t N>
+using re_hist = ivanp::binner<hist_bin,
+  ivanp::tuple_of_same_t<ivanp::axis_spec<re_axis>,N>>;
+
+template <typename T, typename Axis>
+void fill(hist<Axis>& h, const var<T>& x, bool extra_truth_match=true) {
+  const auto bin_det = h.find_bin(x.det);
+  if (is_mc) {
+    const auto bin_truth = h.find_bin(x.truth);
+    h.fill_bin(bin_det, (bin_det == bin_truth) && extra_truth_match);
+  } else h.fill_bin(bin_det);
+}
+
+template <typename T, typename Axis>
+void fill_incl(hist<Axis>& h, const var<T>& x) {
+  const auto bin_det = h.find_bin(x.det);
+  if (is_mc) {
+    const auto bin_truth = h.find_bin(x.truth);
+    for (unsigned i=bin_det; i!=0; --i)
+      h.fill_bin(i, bin_truth >= i);
+  } else for (unsigned i=bin_det; i!=0; --i) h.fill_bin(i);
+}
+
+template <typename T1, typename T2, typename A1, typename A2>
+void fill(hist<A1,A2>& h, const var<T1>& x1, const var<T2>& x2,
+  bool extra_truth_match=true
+) {
+  const auto bin_det = h.find_bin(x1.det,x2.det);
+  if (is_mc) {
+    const auto bin_truth = h.find_bin(x1.truth,x2.truth);
+    h.fill_bin(bin_det, (bin_det == bin_truth) && extra_truth_match);
+  } else h.fill_bin(bin_det);
+}
+
+template <typename F, typename... T>
+auto apply(F f, const var<T>&... vars) -> var<decltype(f(vars.det...))> {
+  if (is_mc) return { f(vars.det...), f(vars.truth...) };
+  else return { f(vars.det...), { } };
+}
+
+// functions applied to variables
+inline double phi_pi4(double phi) noexcept {
+  phi += M_PI_4;
+  return (phi <= M_PI ? phi : phi - M_PI);
+}
+
+#endif
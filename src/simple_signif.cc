@@ -1,14 +1,18 @@
 #include <iostream>
+#include <array>
+#include <algorithm>
+#include <cmath>
 #include <stdexcept>
 #include <regex>
 
 #include <boost/optional.hpp>
 
 #include <TFile.h>
-#include <TTreeReader.h>
-#include <TTreeReaderValue.h>
+#include <TTree.h>
 #include <TH1.h>
-#include <TKey.h>
+
+#include "bulk_reader.hh"
+#include "mxaod_pool.hh"
 
 using std::cout;
 using std::cerr;
@@ -31,8 +35,7 @@ int main(int argc, const char* argv[]) {
   const double data_factor = len(myy_window)/(len(myy_range)-len(myy_window));
   double mc_factor = 1., lumi = 1.;
 
-  std::vector<std::pair<std::unique_ptr<TFile>,bool>> mxaods;
-  mxaods.reserve(argc-1);
+  mxaod_pool mxaods;
 
   for (int a=1; a<argc; ++a) { // loop over arguments
     // validate args and parse names of input files
@@ -48,14 +51,10 @@ int main(int argc, const char* argv[]) {
       lumi += flumi;
       cout << "\033[36mData\033[0m: " << arg << endl;
       cout << "\033[36mLumi\033[0m: " << flumi << " ipb" << endl;
-      mxaods.emplace_back(std::make_unique<TFile>(arg,"read"),false);
-      if (mxaods.back().first->IsZombie())
-        throw std::runtime_error("cannot open root file");
+      mxaods.emplace_back(arg,false);
     } else if (std::regex_search(arg,end,match,mc_re)) { // MC
       cout << "\033[36mMC\033[0m: " << arg << endl;
-      mxaods.emplace_back(std::make_unique<TFile>(arg,"read"),true);
-      if (mxaods.back().first->IsZombie())
-        throw std::runtime_error("cannot open root file");
+      mxaods.emplace_back(arg,true);
     } else {
       cerr << "arg error: unrecognized argument: " << arg << endl;
       return 1;
@@ -69,56 +68,64 @@ int main(int argc, const char* argv[]) {
 
   double sig = 0, bkg = 0;
 
-  for (auto& file : mxaods) { // loop over MxAODs
-    const bool is_mc = file.second;
+  while (mxaod file = mxaods.next()) { // loop over MxAODs
+    const bool is_mc = file.is_mc();
     cout << "\033[36m" << (is_mc ? "MC" : "Data") << "\033[0m: "
-         << file.first->GetName() << endl;
+         << file->GetName() << endl;
 
     if (is_mc) { // MC
-      TIter next(file.first->GetListOfKeys());
-      TKey *key;
-      while ((key = static_cast<TKey*>(next()))) {
-        std::string name(key->GetName());
-        if (name.substr(0,8)!="CutFlow_" ||
-            name.substr(name.size()-18)!="_noDalitz_weighted") continue;
-        TH1 *h = static_cast<TH1*>(key->ReadObj());
-        cout << h->GetName() << endl;
-        const double n_all = h->GetBinContent(3);
-        cout << h->GetXaxis()->GetBinLabel(3) << " = " << n_all << endl;
-        mc_factor = lumi/n_all;
-        break;
-      }
+      const file_info& info = file.info();
+      cout << info.cutflow << endl;
+      cout << "sum of weights = " << info.n_all << endl;
+      mc_factor = lumi/info.n_all;
     }
 
     // read variables ===============================================
-    TTreeReader reader("CollectionTree",file.first.get());
-    optional<TTreeReaderValue<Float_t>> _cs_br_fe, _weight;
+    TTree *tree = nullptr;
+    file->GetObject("CollectionTree",tree);
+    if (!tree) throw std::runtime_error("no CollectionTree");
+
+    using ivanp::bulk_branch;
+    optional<bulk_branch<Float_t>> _cs_br_fe, _weight;
     if (is_mc) {
-      _cs_br_fe.emplace(reader,"HGamEventInfoAuxDyn.crossSectionBRfilterEff");
-      _weight.emplace(reader,"HGamEventInfoAuxDyn.weight");
+      _cs_br_fe.emplace(tree,"HGamEventInfoAuxDyn.crossSectionBRfilterEff");
+      _weight.emplace(tree,"HGamEventInfoAuxDyn.weight");
     }
-    TTreeReaderValue<Char_t> _isPassed(reader,"HGamEventInfoAuxDyn.isPassed");
-    TTreeReaderValue<Float_t> _m_yy(reader,"HGamEventInfoAuxDyn.m_yy");
+    bulk_branch<Char_t> _isPassed(tree,"HGamEventInfoAuxDyn.isPassed");
+    bulk_branch<Float_t> _m_yy(tree,"HGamEventInfoAuxDyn.m_yy");
 
-    while (reader.Next()) { // event loop
+    const Long64_t nent = tree->GetEntries();
+    for (Long64_t ent=0; ent<nent; ) { // loop over baskets
+      // entries up to the nearest basket boundary of any branch
+      Long64_t end = std::min(_isPassed.load(ent), _m_yy.load(ent));
+      if (is_mc)
+        end = std::min({ end, _weight->load(ent), _cs_br_fe->load(ent) });
 
-      // selection cut
-      if (!*_isPassed) continue;
+      const Char_t  *isPassed = _isPassed.data(ent);
+      const Float_t *m_yy = _m_yy.data(ent);
+      const Float_t *weight = is_mc ? _weight->data(ent) : nullptr;
+      const Float_t *cs_br_fe = is_mc ? _cs_br_fe->data(ent) : nullptr;
 
-      // diphoton mass cut
-      const auto m_yy = *_m_yy;
-      if (!in(m_yy,myy_range)) continue;
+      for (Long64_t i=0, n=end-ent; i<n; ++i) { // event loop
 
-      const bool is_in_window = in(m_yy,myy_window);
+        // selection cut
+        if (!isPassed[i]) continue;
 
-      if (is_mc) { // signal from MC
-        if (!is_in_window) continue;
-        sig += (**_weight) * (**_cs_br_fe) * mc_factor;
-      } else { // background from data
-        if (is_in_window) continue;
-        bkg += data_factor;
-      }
+        // diphoton mass cut
+        if (!in(m_yy[i],myy_range)) continue;
 
+        const bool is_in_window = in(m_yy[i],myy_window);
+
+        if (is_mc) { // signal from MC
+          if (!is_in_window) continue;
+          sig += weight[i] * cs_br_fe[i] * mc_factor;
+        } else { // background from data
+          if (is_in_window) continue;
+          bkg += data_factor;
+        }
+
+      }
+      ent = end;
     } // end event loop
 
   } // end file loop
@@ -0,0 +1,210 @@
+#include <iostream>
+#include <vector>
+#include <array>
+#include <memory>
+#include <regex>
+#include <experimental/optional>
+
+#include <TFile.h>
+#include <TTreeReader.h>
+#include <TTreeReaderValue.h>
+#include <TTreeReaderArray.h>
+#include <TH1.h>
+#include <TLorentzVector.h>
+
+#include "timed_counter.hh"
+#include "array_ops.hh"
+#include "exception.hh"
+#include "entry_cache.hh"
+#include "skim_file.hh"
+#include "mxaod_pool.hh"
+
+using std::cout;
+using std::cerr;
+using std::endl;
+using std::experimental::optional;
+
+// global variables =================================================
+bool is_mc;
+// ==================================================================
+#include "truth_reco_var.hh"
+
+TLorentzVector PxPyPzE(const std::array<double,4>& p) noexcept {
+  return { p[0]*1e-3, p[1]*1e-3, p[2]*1e-3, p[3]*1e-3 };
+};
+TLorentzVector PtEtaPhiM(const std::array<double,4>& p) noexcept {
+  TLorentzVector p4;
+  p4.SetPtEtaPhiM( p[0]*1e-3, p[1], p[2], p[3]*1e-3 );
+  return p4;
+};
+
+int main(int argc, const char* argv[]) {
+  const std::array<double,2> myy_range{105e3,160e3};
+
+  mxaod_pool mxaods;
+  std::string fout_name("signif.skim");
+
+  skim::writer skim;
+  skim.myy_range[0] = myy_range[0];
+  skim.myy_range[1] = myy_range[1];
+
+  for (int a=1; a<argc; ++a) { // loop over arguments
+    // validate args and parse names of input files
+    static const std::regex data_re(
+      "^(.*/)?data.*_(\\d*)ipb.*\\.root$", std::regex::optimize);
+    static const std::regex mc_re(
+      "^(.*/)?mc.*\\.root$", std::regex::optimize);
+    static const std::regex fout_re(
+      "out:(.+\\.skim)", std::regex::optimize);
+    static const std::regex cluster_re(
+      "cluster:(.+)", std::regex::optimize);
+    static const std::regex block_re(
+      "block:(\\d+)", std::regex::optimize);
+    std::cmatch match;
+
+    const char *arg = argv[a], *end = arg+std::strlen(arg);
+    if (std::regex_search(arg,end,match,data_re)) { // Data
+      cout << "\033[36mData\033[0m: " << arg << endl;
+      mxaods.emplace_back(arg,false);
+    } else if (std::regex_search(arg,end,match,mc_re)) { // MC
+      cout << "\033[36mMC\033[0m: " << arg << endl;
+      mxaods.emplace_back(arg,true);
+    } else if (std::regex_search(arg,end,match,fout_re)) {
+      fout_name = match[1];
+    } else if (std::regex_search(arg,end,match,cluster_re)) {
+      cout << "\033[36mCluster by\033[0m: " << match[1] << endl;
+      skim.cluster_by(match[1]);
+    } else if (std::regex_search(arg,end,match,block_re)) {
+      skim.block_size = std::stoul(match[1]);
+    } else {
+      cerr << "arg error: unrecognized argument: " << arg << endl;
+      return 1;
+    }
+  }
+  if (!mxaods.size()) {
+    cerr << "Must specify at least 1 .root file" << endl;
+    return 1;
+  }
+  cout << "\033[36mOutput file\033[0m: " << fout_name << endl;
+  // luminosities of data files are taken from the catalog
+  skim.lumi_in = data_lumi(mxaods.catalog());
+  cout << "\n\033[36mTotal data lumi\033[0m: "
+       << skim.lumi_in << " ipb" << endl << endl;
+
+  // Columns ========================================================
+  struct det_truth { size_t det, truth; };
+  const auto add_var = [&skim](const std::string& name) -> det_truth {
+    bool zone_map = false;
+#define ZONE_(NAME) if (name==#NAME) zone_map = true;
+    SKIM_ZONE_VARS(ZONE_)
+#undef ZONE_
+    return { skim.add_column(name,skim::f32,zone_map),
+             skim.add_column(name+".truth",skim::f32) };
+  };
+#define COL_(NAME) const det_truth c_##NAME = add_var(#NAME);
+  SKIM_VARS(COL_)
+#undef COL_
+  const det_truth c_m_yyj = add_var("m_yyj");
+  const size_t c_weight = skim.add_column("weight",skim::f32);
+  const size_t c_flags  = skim.add_column("flags",skim::u8);
+
+  while (mxaod file = mxaods.next()) { // loop over MxAODs
+    is_mc = file.is_mc();
+    cout << "\033[36m" << (is_mc ? "MC" : "Data") << "\033[0m: "
+         << file->GetName() << endl;
+
+    double n_all_inv = 1.;
+    if (is_mc) { // MC
+      const file_info& info = file.info();
+      cout << info.cutflow << endl;
+      cout << "sum of weights = " << info.n_all << endl;
+      n_all_inv = 1./info.n_all;
+    } else {
+      cout << "\033[36mLumi\033[0m: " << file.info().lumi << " ipb" << endl;
+    }
+
+    // read variables ===============================================
+    TTree *tree = nullptr;
+    file->GetObject("CollectionTree",tree);
+    if (!tree) throw ivanp::exception("no CollectionTree in ",file->GetName());
+    // only entries passing isPassed and myy_range
+    const auto elist = make_entry_list(*file,"CollectionTree",myy_range);
+    TTreeReader reader(tree,elist.get());
+    optional<TTreeReaderValue<Float_t>> _cs_br_fe, _weight;
+    optional<TTreeReaderValue<Char_t>> _isFiducial;
+    if (is_mc) {
+      _cs_br_fe.emplace(reader,"HGamEventInfoAuxDyn.crossSectionBRfilterEff");
+      _weight.emplace(reader,"HGamEventInfoAuxDyn.weight");
+      _isFiducial.emplace(reader,"HGamTruthEventInfoAuxDyn.isFiducial");
+    }
+
+#define VAR_GEN_(NAME, TYPE, STR) \
+  var<TTreeReaderValue<TYPE>> _##NAME(reader, STR);
+#define VAR_(NAME) VAR_GEN_(NAME, Float_t, #NAME)
+#define VAR30_(NAME) VAR_GEN_(NAME, Float_t, #NAME "_30")
+
+    VAR_GEN_(N_j, Int_t, "N_j_30")
+
+    VAR_(m_yy) VAR_(pT_yy) VAR_(yAbs_yy) VAR_(cosTS_yy) VAR_(pTt_yy)
+    VAR_(Dy_y_y)
+
+    VAR30_(HT)
+    VAR30_(pT_j1)      VAR30_(pT_j2)      VAR30_(pT_j3)
+    VAR30_(yAbs_j1)    VAR30_(yAbs_j2)
+    VAR30_(Dphi_j_j)   VAR_GEN_(Dphi_j_j_signed,Float_t,"Dphi_j_j_30_signed")
+    VAR30_(Dy_j_j)     VAR30_(m_jj)
+    VAR30_(sumTau_yyj) VAR30_(maxTau_yyj)
+    VAR30_(pT_yyjj)    VAR30_(Dphi_yy_jj)
+
+    var<std::array<TTreeReaderArray<float>,4>>
+    _photons( reader,
+      {"HGamPhotonsAuxDyn.","HGamTruthPhotonsAuxDyn."},
+      {"pt","eta","phi","m"}, {"px","py","pz","e"} ),
+    _jets( reader,
+      {"HGamAntiKt4EMTopoJetsAuxDyn.","HGamAntiKt4TruthJetsAuxDyn."},
+      {"pt","eta","phi","m"} );
+
+    // loop over events =============================================
+    using tc = ivanp::timed_counter<Long64_t>;
+    for (tc ent(reader.GetEntries(true)); reader.Next(); ++ent) {
+      const auto m_yy = *_m_yy;
+      uint8_t flags = 0;
+
+      if (is_mc) {
+        skim(c_weight, (**_weight) * (**_cs_br_fe) * n_all_inv);
+        flags |= skim::mc_flag;
+        if (**_isFiducial && in(m_yy.truth,myy_range))
+          flags |= skim::fiducial_flag;
+      } else skim(c_weight, 1.);
+      skim(c_flags, flags);
+
+      // m_yyj is only defined with at least 1 jet
+      var<double> m_yyj{0.,0.};
+      if (*_N_j >= 1) {
+        auto yyj  = (_jets   [0] | PtEtaPhiM);
+             yyj += (_photons[0] | std::make_pair(PtEtaPhiM,PxPyPzE));
+             yyj += (_photons[1] | std::make_pair(PtEtaPhiM,PxPyPzE));
+        m_yyj = yyj|[](auto& x){ return x.M(); };
+      }
+
+#define COL_(NAME) { \
+  const auto x = *_##NAME; \
+  skim(c_##NAME.det, x.det); \
+  skim(c_##NAME.truth, x.truth); \
+}
+      SKIM_VARS(COL_)
+#undef COL_
+      skim(c_m_yyj.det, m_yyj.det);
+      skim(c_m_yyj.truth, m_yyj.truth);
+
+      skim.next();
+    }
+
+    file->Close();
+  }
+
+  cout << "\nWriting " << skim.nevents() << " events" << endl;
+  skim.write(fout_name);
+
+  return 0;
+}
@@ -0,0 +1,368 @@
+#ifndef SKIM_FILE_HH
+#define SKIM_FILE_HH
+
+#include <string>
+#include <vector>
+#include <fstream>
+#include <algorithm>
+#include <numeric>
+#include <cstring>
+#include <cstdint>
+
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <unistd.h>
+
+#include "exception.hh"
+
+/*
+ * Columnar skim of selected events
+ *
+ * Layout:
+ *   header
+ *   column_info[ncols]
+ *   column data, each column aligned to 64 bytes
+ *   zone maps, each aligned to 64 bytes
+ *
+ * Events are grouped into blocks of block_size events.
+ * Columns with a zone map have min and max values stored for every block,
+ * which allows queries to skip blocks that cannot pass a cut.
+ * Events can be clustered (stably sorted) by a column when the skim is
+ * written, e.g. by N_j, so that jet multiplicity categories occupy
+ * contiguous blocks.
+ *
+ * Only events with isPassed and m_yy in myy_range are stored.
+ * Detector and truth level values are separate columns,
+ * truth columns have the ".truth" suffix and are 0 for data.
+ * Energies and momenta are in MeV, as in the MxAODs.
+ * The "weight" column is already normalized:
+ *   MC:   weight * crossSectionBRfilterEff / n_all   (events per ipb)
+ *   data: 1
+ * The "flags" column holds the skim_flags bits.
+ */
+
+namespace skim {
+
+constexpr char magic[8] = {'S','I','G','N','S','K','I','M'};
+constexpr uint32_t version = 2;
+
+enum skim_flags : uint8_t {
+  mc_flag = 1, // event is from MC
+  fiducial_flag = 2 // isFiducial and truth m_yy in myy_range
+};
+
+enum column_type : uint32_t { f32 = 0, u8 = 1 };
+
+struct header {
+  char magic[8];
+  uint32_t version, ncols;
+  uint64_t nevents;
+  double lumi_in; // integrated data luminosity, ipb
+  double myy_range[2];
+  uint32_t block_size, pad;
+};
+
+struct column_info {
+  char name[48];
+  uint32_t type, pad;
+  uint64_t offset; // from the beginning of the file
+  uint64_t zone_offset; // 0 if there is no zone map
+};
+
+// MxAOD variables stored with det and truth values
+// in addition, m_yyj (in GeV) is computed from the photons and leading jet
+#define SKIM_VARS(F) \
+  F(N_j) F(m_yy) F(pT_yy) F(yAbs_yy) F(cosTS_yy) F(pTt_yy) F(Dy_y_y) \
+  F(HT) F(pT_j1) F(pT_j2) F(pT_j3) F(yAbs_j1) F(yAbs_j2) \
+  F(Dphi_j_j) F(Dphi_j_j_signed) F(Dy_j_j) F(m_jj) \
+  F(sumTau_yyj) F(maxTau_yyj) F(pT_yyjj) F(Dphi_yy_jj)
+
+// columns with zone maps
+#define SKIM_ZONE_VARS(F) F(N_j) F(m_yy) F(pT_yy) F(m_jj)
+
+inline uint64_t align64(uint64_t x) noexcept { return (x + 63) & ~63ull; }
+
+inline uint64_t nblocks(uint64_t nevents, uint32_t block_size) noexcept {
+  return (nevents + block_size - 1) / block_size;
+}
+
+// Writer ===========================================================
+
+class writer {
+  struct column {
+    std::string name;
+    column_type type;
+    bool zone_map;
+    std::vector<char> data;
+  };
+  std::vector<column> cols;
+  uint64_t n = 0;
+  std::string cluster_col;
+
+  template <typename T>
+  void permute(std::vector<char>& data, const std::vector<uint64_t>& perm) {
+    std::vector<char> tmp(data.size());
+    const T *in = reinterpret_cast<const T*>(data.data());
+    T *out = reinterpret_cast<T*>(tmp.data());
+    for (uint64_t i=0; i<n; ++i) out[i] = in[perm[i]];
+    data.swap(tmp);
+  }
+
+  // stable sort of all columns by the values of one column
+  void cluster() {
+    const auto it = std::find_if(cols.begin(),cols.end(),
+      [this](const column& c){ return c.name==cluster_col; });
+    if (it==cols.end() || it->type!=f32) throw ivanp::exception(
+      "cannot cluster skim by ",cluster_col);
+    const float *x = reinterpret_cast<const float*>(it->data.data());
+    std::vector<uint64_t> perm(n);
+    std::iota(perm.begin(),perm.end(),0);
+    std::stable_sort(perm.begin(),perm.end(),
+      [x](uint64_t a, uint64_t b){ return x[a] < x[b]; });
+    for (auto& c : cols) {
+      if (c.type==f32) permute<float>(c.data,perm);
+      else permute<uint8_t>(c.data,perm);
+    }
+  }
+
+  std::vector<float> make_zone_map(const column& c) const {
+    const float *x = reinterpret_cast<const float*>(c.data.data());
+    const uint64_t nb = nblocks(n,block_size);
+    std::vector<float> zm(2*nb);
+    for (uint64_t b=0; b<nb; ++b) {
+      const float *first = x + b*block_size;
+      const float *last = x + std::min(n,(b+1)*block_size);
+      const auto mm = std::minmax_element(first,last);
+      zm[2*b  ] = *mm.first;
+      zm[2*b+1] = *mm.second;
+    }
+    return zm;
+  }
+
+public:
+  double lumi_in = 0;
+  double myy_range[2] = {0,0};
+  uint32_t block_size = 1u<<14;
+
+  // returns column index used for filling
+  size_t add_column(const std::string& name, column_type type,
+    bool zone_map=false
+  ) {
+    if (name.size() >= sizeof(column_info::name))
+      throw ivanp::exception("skim column name too long: ",name);
+    for (const auto& c : cols) if (c.name==name)
+      throw ivanp::exception("repeated skim column ",name);
+    if (zone_map && type!=f32) throw ivanp::exception(
+      "zone maps are only supported for float columns");
+    cols.push_back({name,type,zone_map,{}});
+    return cols.size()-1;
+  }
+
+  // sort events by this column before writing
+  void cluster_by(const std::string& name) { cluster_col = name; }
+
+  // values are appended column by column,
+  // call next() after all columns of an event are set
+  template <typename T>
+  void operator()(size_t i, T x) {
+    auto& c = cols[i];
+    if (c.type==f32) {
+      const float v = x;
+      c.data.insert(c.data.end(),
+        reinterpret_cast<const char*>(&v),
+        reinterpret_cast<const char*>(&v)+sizeof(v));
+    } else {
+      c.data.push_back(static_cast<uint8_t>(x));
+    }
+  }
+  void next() { ++n; }
+  inline uint64_t nevents() const noexcept { return n; }
+
+  void write(const std::string& fname) {
+    if (block_size==0) throw ivanp::exception("skim block size is 0");
+    for (const auto& c : cols) {
+      const uint64_t expected = n * (c.type==f32 ? 4 : 1);
+      if (c.data.size()!=expected) throw ivanp::exception(
+        "skim column ",c.name," has ",c.data.size()," bytes instead of ",
+        expected);
+    }
+
+    if (!cluster_col.empty()) cluster();
+
+    std::vector<std::vector<float>> zone_maps;
+    for (const auto& c : cols)
+      zone_maps.push_back(c.zone_map ? make_zone_map(c) : std::vector<float>());
+
+    std::ofstream f(fname, std::ios::binary);
+    if (!f) throw ivanp::exception("cannot write ",fname);
+
+    header h { };
+    std::memcpy(h.magic,magic,sizeof(magic));
+    h.version = version;
+    h.ncols = cols.size();
+    h.nevents = n;
+    h.lumi_in = lumi_in;
+    h.myy_range[0] = myy_range[0];
+    h.myy_range[1] = myy_range[1];
+    h.block_size = block_size;
+    f.write(reinterpret_cast<const char*>(&h),sizeof(h));
+
+    uint64_t offset = align64(sizeof(h) + cols.size()*sizeof(column_info));
+    std::vector<column_info> infos(cols.size());
+    for (size_t i=0; i<cols.size(); ++i) {
+      std::strcpy(infos[i].name,cols[i].name.c_str());
+      infos[i].type = cols[i].type;
+      infos[i].offset = offset;
+      offset = align64(offset + cols[i].data.size());
+    }
+    for (size_t i=0; i<cols.size(); ++i) {
+      if (!cols[i].zone_map) continue;
+      infos[i].zone_offset = offset;
+      offset = align64(offset + zone_maps[i].size()*sizeof(float));
+    }
+    f.write(reinterpret_cast<const char*>(infos.data()),
+      infos.size()*sizeof(column_info));
+
+    for (const auto& c : cols) {
+      f.seekp(align64(f.tellp()));
+      f.write(c.data.data(),c.data.size());
+    }
+    for (const auto& zm : zone_maps) {
+      if (zm.empty()) continue;
+      f.seekp(align64(f.tellp()));
+      f.write(reinterpret_cast<const char*>(zm.data()),zm.size()*sizeof(float));
+    }
+  }
+};
+
+// Reader ===========================================================
+
+class reader {
+  int fd = -1;
+  size_t len = 0;
+  const char *base = nullptr;
+
+public:
+  reader(const std::string& fname) {
+    fd = open(fname.c_str(),O_RDONLY);
+    if (fd < 0) throw ivanp::exception("cannot open ",fname);
+    struct stat st;
+    fstat(fd,&st);
+    len = st.st_size;
+    if (len < sizeof(header)) throw ivanp::exception("bad skim file ",fname);
+    void *p = mmap(nullptr,len,PROT_READ,MAP_PRIVATE,fd,0);
+    if (p==MAP_FAILED) throw ivanp::exception("cannot mmap ",fname);
+    base = static_cast<const char*>(p);
+    madvise(p,len,MADV_SEQUENTIAL);
+
+    if (std::memcmp(head().magic,magic,sizeof(magic)))
+      throw ivanp::exception(fname," is not a skim file");
+    if (head().version!=version) throw ivanp::exception(
+      fname," has skim version ",head().version," instead of ",version);
+  }
+  ~reader() {
+    if (base) munmap(const_cast<char*>(base),len);
+    if (fd >= 0) close(fd);
+  }
+  reader(const reader&) = delete;
+  reader& operator=(const reader&) = delete;
+  reader(reader&& o) noexcept: fd(o.fd), len(o.len), base(o.base) {
+    o.fd = -1;
+    o.base = nullptr;
+  }
+
+  inline const header& head() const noexcept {
+    return *reinterpret_cast<const header*>(base);
+  }
+  inline uint64_t nevents() const noexcept { return head().nevents; }
+  inline uint32_t block_size() const noexcept { return head().block_size; }
+  inline uint64_t nblocks() const noexcept {
+    return skim::nblocks(nevents(),block_size());
+  }
+
+  inline const column_info* columns() const noexcept {
+    return reinterpret_cast<const column_info*>(base+sizeof(header));
+  }
+  const column_info& info(const std::string& name) const {
+    const auto* c = columns();
+    for (uint32_t i=0; i<head().ncols; ++i, ++c)
+      if (name==c->name) return *c;
+    throw ivanp::exception("no skim column ",name);
+  }
+
+  template <typename T>
+  const T* column(const std::string& name) const {
+    const auto& c = info(name);
+    if (sizeof(T) != (c.type==f32 ? 4u : 1u)) throw ivanp::exception(
+      "wrong type requested for skim column ",name);
+    return reinterpret_cast<const T*>(base+c.offset);
+  }
+
+  // [min,max] pairs for every block, or nullptr if there is no zone map
+  const float* zone_map(const std::string& name) const {
+    const auto& c = info(name);
+    if (!c.zone_offset) return nullptr;
+    return reinterpret_cast<const float*>(base+c.zone_offset);
+  }
+};
+
+// Cut ==============================================================
+
+// cut on a float column, e.g. "N_j>=2" or "m_yy<130e3"
+// uses the column's zone map, if there is one, to skip blocks
+class cut {
+  enum op_t { lt, le, gt, ge, eq } op;
+  double value;
+  const float *x = nullptr, *zone = nullptr;
+
+public:
+  std::string name;
+
+  cut(const std::string& str) {
+    const auto p = str.find_first_of("<>=");
+    if (p==0 || p==std::string::npos)
+      throw ivanp::exception("bad cut expression: ",str);
+    name = str.substr(0,p);
+    const bool e = (p+1 < str.size() && str[p+1]=='=');
+    switch (str[p]) {
+      case '<': op = e ? le : lt; break;
+      case '>': op = e ? ge : gt; break;
+      default : op = eq;
+    }
+    value = std::stod(str.substr(p+1+e));
+  }
+
+  void bind(const reader& f) {
+    x = f.column<float>(name);
+    zone = f.zone_map(name);
+  }
+
+  inline bool operator()(uint64_t i) const noexcept {
+    const double v = x[i];
+    switch (op) {
+      case lt: return v <  value;
+      case le: return v <= value;
+      case gt: return v >  value;
+      case ge: return v >= value;
+      default: return v == value;
+    }
+  }
+
+  // false only if no event in the block can pass
+  inline bool block(uint64_t b) const noexcept {
+    if (!zone) return true;
+    const double min = zone[2*b], max = zone[2*b+1];
+    switch (op) {
+      case lt: return min <  value;
+      case le: return min <= value;
+      case gt: return max >  value;
+      case ge: return max >= value;
+      default: return min <= value && value <= max;
+    }
+  }
+};
+
+} // end namespace skim
+
+#endif
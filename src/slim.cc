@@ -0,0 +1,258 @@
+#include <iostream>
+#include <string>
+#include <vector>
+#include <array>
+#include <memory>
+#include <regex>
+#include <cstring>
+
+#include <TFile.h>
+#include <TTree.h>
+#include <TKey.h>
+#include <TH1.h>
+#include <TSystem.h>
+#include <Compression.h>
+
+#include "timed_counter.hh"
+#include "exception.hh"
+#include "entry_cache.hh"
+
+using std::cout;
+using std::cerr;
+using std::endl;
+
+// Branches read by the analysis executables ========================
+
+// HGamEventInfoAuxDyn. and HGamTruthEventInfoAuxDyn.
+const char* event_vars[] = {
+  "m_yy", "pT_yy", "yAbs_yy", "cosTS_yy", "pTt_yy", "Dy_y_y"
+};
+// with a jet pT threshold suffix, e.g. _30, inserted before the
+// remainder after '|'
+const char* jet_vars[] = {
+  "N_j",
+  "HT",
+  "pT_j1", "pT_j2", "pT_j3",
+  "yAbs_j1", "yAbs_j2",
+  "Dphi_j_j", "Dphi_j_j|_signed",
+  "Dy_j_j", "m_jj",
+  "sumTau_yyj", "maxTau_yyj",
+  "pT_yyjj", "Dphi_yy_jj"
+};
+const char* reco_only[] = {
+  "HGamEventInfoAuxDyn.isPassed",
+  // bootstrap seeds
+  "EventInfoAux.runNumber", "EventInfoAux.eventNumber",
+  "EventInfoAux.mcChannelNumber"
+};
+const char* mc_only[] = {
+  "HGamEventInfoAuxDyn.weight",
+  "HGamEventInfoAuxDyn.crossSectionBRfilterEff",
+  "HGamTruthEventInfoAuxDyn.isFiducial"
+};
+// object containers and their 4-momentum leaves
+using leaves = std::array<const char*,4>;
+const leaves p4_ptetaphim {"pt","eta","phi","m"},
+             p4_pxpypze   {"px","py","pz","e"};
+const std::pair<const char*,leaves> det_objects[] = {
+  {"HGamPhotonsAuxDyn.", p4_ptetaphim},
+  {"HGamAntiKt4EMTopoJetsAuxDyn.", p4_ptetaphim}
+};
+const std::pair<const char*,leaves> truth_objects[] = {
+  {"HGamTruthPhotonsAuxDyn.", p4_pxpypze},
+  {"HGamAntiKt4TruthJetsAuxDyn.", p4_ptetaphim}
+};
+
+std::vector<std::string> slim_branches(
+  bool is_mc, const std::vector<std::string>& jet_pts
+) {
+  std::vector<std::string> names;
+  for (const char* name : reco_only) names.emplace_back(name);
+  std::vector<std::string> vars(std::begin(event_vars),std::end(event_vars));
+  for (const auto& pt : jet_pts)
+    for (std::string var : jet_vars) {
+      const auto sep = var.find('|');
+      if (sep==std::string::npos) var += "_"+pt;
+      else var.replace(sep,1,"_"+pt);
+      vars.push_back(std::move(var));
+    }
+  for (const auto& var : vars) {
+    names.emplace_back("HGamEventInfoAuxDyn."+var);
+    if (is_mc)
+      names.emplace_back("HGamTruthEventInfoAuxDyn."+var);
+  }
+  for (const auto& obj : det_objects)
+    for (const char* leaf : obj.second)
+      names.emplace_back(std::string(obj.first)+leaf);
+  if (is_mc) {
+    for (const char* name : mc_only) names.emplace_back(name);
+    for (const auto& obj : truth_objects)
+      for (const char* leaf : obj.second)
+        names.emplace_back(std::string(obj.first)+leaf);
+  }
+  return names;
+}
+
+int main(int argc, const char* argv[]) {
+  const std::array<double,2> myy_range{105e3,160e3};
+
+  std::vector<std::pair<std::string,bool>> mxaods;
+  mxaods.reserve(argc-1);
+  std::string out_dir("slim");
+  std::vector<std::string> jet_pts; // jet pT thresholds to keep, GeV
+  // additional MC branches, e.g. the weight variations for signif
+  std::vector<std::string> keep_mc;
+  // sequential reads of ~30 branches: large baskets and clusters,
+  // LZ4 trades some file size for much faster decompression
+  Int_t basket_size = 256*1024;
+  Long64_t cluster_bytes = 64*1024*1024;
+  int compression = ROOT::CompressionSettings(ROOT::kLZ4,4);
+
+  for (int a=1; a<argc; ++a) { // loop over arguments
+    static const std::regex data_re(
+      "^(.*/)?data.*_(\\d*)ipb.*\\.root$", std::regex::optimize);
+    static const std::regex mc_re(
+      "^(.*/)?mc.*\\.root$", std::regex::optimize);
+    static const std::regex dir_re(
+      "out:(.+)", std::regex::optimize);
+    static const std::regex basket_re(
+      "basket:(\\d+)k", std::regex::optimize);
+    static const std::regex cluster_re(
+      "cluster:(\\d+)M", std::regex::optimize);
+    static const std::regex jets_re(
+      "^jets:([0-9]+(,[0-9]+)*)$", std::regex::optimize);
+    static const std::regex keep_re(
+      "^keep:(.+)$", std::regex::optimize);
+    static const std::regex comp_re(
+      "comp:(\\d+)", std::regex::optimize);
+    std::cmatch match;
+
+    const char *arg = argv[a], *end = arg+std::strlen(arg);
+    if (std::regex_search(arg,end,match,data_re)) { // Data
+      mxaods.emplace_back(arg,false);
+    } else if (std::regex_search(arg,end,match,mc_re)) { // MC
+      mxaods.emplace_back(arg,true);
+    } else if (std::regex_search(arg,end,match,dir_re)) {
+      out_dir = match[1];
+    } else if (std::regex_search(arg,end,match,basket_re)) {
+      basket_size = std::stoi(match[1])*1024;
+    } else if (std::regex_search(arg,end,match,cluster_re)) {
+      cluster_bytes = std::stoll(match[1])*1024*1024;
+    } else if (std::regex_search(arg,end,match,jets_re)) {
+      const std::string list = match[1];
+      for (size_t p=0, q; p<list.size(); p=q+1) {
+        q = list.find(',',p);
+        if (q==std::string::npos) q = list.size();
+        jet_pts.push_back(list.substr(p,q-p));
+      }
+    } else if (std::regex_search(arg,end,match,keep_re)) {
+      // same list as signif weights:, array branches may end in []
+      const std::string list = match[1];
+      for (size_t p=0, q; p<list.size(); p=q+1) {
+        q = list.find(',',p);
+        if (q==std::string::npos) q = list.size();
+        std::string name = list.substr(p,q-p);
+        if (name.size()>2 && !name.compare(name.size()-2,2,"[]"))
+          name.resize(name.size()-2);
+        keep_mc.push_back(std::move(name));
+      }
+    } else if (std::regex_search(arg,end,match,comp_re)) {
+      compression = std::stoi(match[1]);
+    } else {
+      cerr << "arg error: unrecognized argument: " << arg << endl;
+      return 1;
+    }
+  }
+  if (!mxaods.size()) {
+    cerr << "Must specify at least 1 .root file" << endl;
+    return 1;
+  }
+  if (jet_pts.empty()) jet_pts.push_back("30");
+  while (out_dir.size()>1 && out_dir.back()=='/') out_dir.pop_back();
+  cout << "\033[36mOutput directory\033[0m: " << out_dir << endl;
+  cout << "\033[36mBasket size\033[0m: " << basket_size/1024 << " kB" << endl;
+  cout << "\033[36mCluster size\033[0m: "
+       << cluster_bytes/(1024*1024) << " MB" << endl;
+  cout << "\033[36mCompression\033[0m: " << compression << endl;
+  cout << "\033[36mJet pT thresholds\033[0m:";
+  for (const auto& pt : jet_pts) cout << ' ' << pt;
+  cout << " GeV" << endl;
+  if (!keep_mc.empty()) {
+    cout << "\033[36mAlso keep in MC\033[0m:";
+    for (const auto& name : keep_mc) cout << ' ' << name;
+    cout << endl;
+  }
+  cout << endl;
+  gSystem->mkdir(out_dir.c_str(),true);
+
+  for (const auto& input : mxaods) { // loop over MxAODs
+    const bool is_mc = input.second;
+    auto fin = std::make_unique<TFile>(input.first.c_str(),"read");
+    if (fin->IsZombie())
+      throw ivanp::exception("cannot open file ",input.first);
+    cout << "\033[36m" << (is_mc ? "MC" : "Data") << "\033[0m: "
+         << fin->GetName() << endl;
+
+    TTree *tree = nullptr;
+    fin->GetObject("CollectionTree",tree);
+    if (!tree) throw ivanp::exception("no CollectionTree in ",fin->GetName());
+
+    // preselection: isPassed and myy_range
+    const auto entries =
+      selected_entries(fin.get(),"CollectionTree",myy_range);
+
+    // keep only analysis branches
+    auto branches = slim_branches(is_mc,jet_pts);
+    if (is_mc) branches.insert(branches.end(),keep_mc.begin(),keep_mc.end());
+    tree->SetBranchStatus("*",0);
+    for (const auto& name : branches) {
+      if (!tree->GetBranch(name.c_str()))
+        throw ivanp::exception("no branch ",name," in ",fin->GetName());
+      tree->SetBranchStatus(name.c_str(),1);
+    }
+
+    const std::string fout_name = out_dir + '/' +
+      input.first.substr(input.first.rfind('/')+1);
+    auto fout = std::make_unique<TFile>(
+      fout_name.c_str(),"recreate","",compression);
+    if (fout->IsZombie())
+      throw ivanp::exception("cannot open file ",fout_name);
+
+    // copy cutflow histograms used for normalization
+    if (is_mc) {
+      TIter next(fin->GetListOfKeys());
+      TKey *key;
+      while ((key = static_cast<TKey*>(next()))) {
+        std::string name(key->GetName());
+        if (name.substr(0,8)!="CutFlow_" ||
+            name.substr(name.size()-18)!="_noDalitz_weighted") continue;
+        TH1 *h = static_cast<TH1*>(key->ReadObj());
+        fout->cd();
+        h->Write();
+      }
+    }
+
+    fout->cd();
+    TTree *slim = tree->CloneTree(0);
+    slim->SetAutoFlush(-cluster_bytes);
+    slim->SetBasketSize("*",basket_size);
+
+    // loop over selected entries ===================================
+    using tc = ivanp::timed_counter<Long64_t>;
+    for (tc i(entries.size()); i < Long64_t(entries.size()); ++i) {
+      tree->GetEntry(entries[Long64_t(i)]);
+      slim->Fill();
+    }
+
+    cout << "Kept " << slim->GetEntries() << " of " << tree->GetEntries()
+         << " entries and " << branches.size() << " of "
+         << tree->GetListOfBranches()->GetEntries() << " branches" << endl;
+    cout << "\033[36mWrote\033[0m: " << fout_name << endl << endl;
+
+    fout->Write(0,TObject::kOverwrite);
+    fout->Close();
+    fin->Close();
+  }
+
+  return 0;
+}
@@ -0,0 +1,108 @@
+#ifndef IVANP_SPARSE_BINS_HH
+#define IVANP_SPARSE_BINS_HH
+
+#include <vector>
+#include <unordered_map>
+#include <algorithm>
+#include <utility>
+
+namespace ivanp {
+
+// Sparse bins container for binner
+// Bins are created on first access and kept in a hash map while filling.
+// compress(row_length) converts them to compressed row storage,
+// ordered by index, for iteration over the filled bins of each row.
+// Reading an empty bin returns a default constructed value.
+
+template <typename T>
+class sparse_bins {
+public:
+  using value_type = T;
+  using size_type = size_t;
+
+private:
+  size_type _size, _row_length;
+  std::unordered_map<size_type,value_type> _fill;
+  // compressed row storage
+  std::vector<size_type> _row_ptr, _col;
+  std::vector<value_type> _val;
+  static const value_type _empty;
+
+  void decompress() {
+    const size_type nrows = _row_ptr.size()-1;
+    for (size_type r=0; r<nrows; ++r)
+      for (size_type k=_row_ptr[r]; k<_row_ptr[r+1]; ++k)
+        _fill.emplace(r*_row_length+_col[k], std::move(_val[k]));
+    _row_ptr.clear();
+    _col.clear();
+    _val.clear();
+  }
+
+public:
+  sparse_bins(size_type n=0): _size(n), _row_length(0) { }
+
+  inline size_type size() const noexcept { return _size; }
+  inline bool compressed() const noexcept { return !_row_ptr.empty(); }
+  inline size_type nnz() const noexcept {
+    return compressed() ? _val.size() : _fill.size();
+  }
+
+  inline value_type& operator[](size_type i) {
+    if (__builtin_expect(compressed(),0)) decompress();
+    return _fill[i];
+  }
+  const value_type& operator[](size_type i) const {
+    if (compressed()) {
+      const size_type r = i/_row_length, c = i%_row_length;
+      const auto begin = _col.begin()+_row_ptr[r];
+      const auto end   = _col.begin()+_row_ptr[r+1];
+      const auto it = std::lower_bound(begin,end,c);
+      return (it!=end && *it==c) ? _val[it-_col.begin()] : _empty;
+    } else {
+      const auto it = _fill.find(i);
+      return it!=_fill.end() ? it->second : _empty;
+    }
+  }
+
+  void compress(size_type row_length) {
+    if (compressed()) decompress();
+    _row_length = row_length;
+    using pair = std::pair<size_type,value_type>;
+    std::vector<pair> bins(
+      std::make_move_iterator(_fill.begin()),
+      std::make_move_iterator(_fill.end()));
+    _fill.clear();
+    std::sort(bins.begin(),bins.end(),
+      [](const pair& a, const pair& b){ return std::get<0>(a) < std::get<0>(b); });
+
+    const size_type nrows = (_size + row_length - 1)/row_length;
+    _row_ptr.assign(nrows+1,0);
+    _col.reserve(bins.size());
+    _val.reserve(bins.size());
+    for (auto& b : bins) {
+      ++_row_ptr[b.first/row_length+1];
+      _col.push_back(b.first%row_length);
+      _val.push_back(std::move(b.second));
+    }
+    for (size_type r=0; r<nrows; ++r) _row_ptr[r+1] += _row_ptr[r];
+  }
+
+  // row access after compress()
+  inline size_type row_length() const noexcept { return _row_length; }
+  inline size_type nrows() const noexcept { return _row_ptr.size()-1; }
+  inline size_type row_begin(size_type r) const noexcept {
+    return _row_ptr[r];
+  }
+  inline size_type row_end(size_type r) const noexcept {
+    return _row_ptr[r+1];
+  }
+  inline size_type col(size_type k) const noexcept { return _col[k]; }
+  inline const value_type& val(size_type k) const noexcept { return _val[k]; }
+};
+
+template <typename T>
+const T sparse_bins<T>::_empty { };
+
+} // end namespace ivanp
+
+#endif
@@ -4,19 +4,24 @@
 #include <array>
 #include <memory>
 #include <regex>
+#include <string>
 #include <experimental/optional>
 
 #include <TFile.h>
+#include <TTree.h>
 #include <TTreeReader.h>
 #include <TTreeReaderValue.h>
 #include <TH1.h>
-#include <TKey.h>
+#include <TH2.h>
 
 #include "binner.hh"
 #include "re_axes.hh"
 #include "timed_counter.hh"
 #include "array_ops.hh"
 #include "exception.hh"
+#include "entry_cache.hh"
+#include "mxaod_pool.hh"
+#include "sparse_bins.hh"
 
 #define test(var) \
   std::cout <<"\033[36m"<< #var <<"\033[0m"<< " = " << var << std::endl;
@@ -27,32 +32,29 @@ using std::endl;
 using std::experimental::optional;
 
 // global variables =================================================
-bool is_mc;
+bool is_mc, is_fiducial, is_in_window;
 // ==================================================================
-
-class mxaod {
-  TFile *ptr;
-  bool _is_mc;
-public:
-  mxaod(const char* fname, bool _is_mc)
-  : ptr(new TFile(fname,"read")), _is_mc(_is_mc) {
-    if (ptr->IsZombie()) throw ivanp::exception("cannot open file ",fname);
-  }
-  ~mxaod() { delete ptr; }
-  mxaod(const mxaod& o) = delete;
-  mxaod(mxaod&& o) noexcept: ptr(o.ptr), _is_mc(o._is_mc) { o.ptr = nullptr; }
-  inline TFile* operator->() const noexcept { return ptr; }
-  inline TFile* operator* () const noexcept { return ptr; }
-  inline bool is_mc() const noexcept { return _is_mc; }
-};
+#include "truth_reco_var.hh"
 
 struct hist_bin {
   static double weight;
-  double bkg = 0, sig = 0; // for significance
+  double
+    bkg = 0, sig = 0, // for significance
+    bkg2 = 0, sig2 = 0, // square for uncertainty
+    reco = 0; // for purity
 
-  void operator++() noexcept {
-    if (is_mc) sig += weight;
-    else bkg += weight;
+  void operator()() {
+    if (is_mc) {
+      if (is_in_window) { // cut for significance
+        sig += weight;
+        sig2 += weight*weight;
+      }
+      reco += weight;
+    } else {
+      // the cut is in the event loop
+      bkg += weight;
+      bkg2 += weight*weight;
+    }
   }
 };
 double hist_bin::weight;
@@ -66,6 +68,46 @@ template <size_t N>
 using re_hist = ivanp::binner<hist_bin,
   ivanp::tuple_of_same_t<ivanp::axis_spec<re_axis>,N>>;
 
+// 1D histogram with the det x truth migration of its fiducial events
+// Most of the weight is near the diagonal, so the migration is kept
+// sparsely, at det*nbins + truth, with under- and overflow bins
+struct mig_hist {
+  std::string name;
+  re_hist<1> h;
+  ivanp::sparse_bins<double> mig;
+  static std::vector<mig_hist*> all;
+
+  mig_hist(const std::string& name, const re_axis& axis)
+  : name(name), h(name,axis), mig(h.nbins()*h.nbins()) {
+    all.push_back(this);
+  }
+  mig_hist(const mig_hist&) = delete;
+  mig_hist& operator=(const mig_hist&) = delete;
+};
+std::vector<mig_hist*> mig_hist::all;
+
+// edges of a fine axis, which need not be uniform, for ROOT histograms
+std::vector<double> edges(const re_axis& ax) {
+  std::vector<double> e(ax.nedges());
+  for (unsigned i=0; i<e.size(); ++i) e[i] = ax.edge(i);
+  return e;
+}
+
+template <typename T>
+void fill(mig_hist& m, const var<T>& x, bool extra_truth_match=true) {
+  auto& h = m.h;
+  const auto bin_det = h.find_bin(x.det);
+  h.fill_bin(bin_det);
+  if (is_mc && is_fiducial && extra_truth_match)
+    m.mig[bin_det*h.nbins() + h.find_bin(x.truth)] += hist_bin::weight;
+}
+
+// 2D grids are only for significance
+template <typename T1, typename T2>
+void fill(re_hist<2>& h, const var<T1>& x1, const var<T2>& x2) {
+  h.fill_bin(h.find_bin(x1.det,x2.det));
+}
+
 // functions applied to variables
 inline double phi_pi4(double phi) noexcept {
   phi += M_PI_4;
@@ -75,10 +117,9 @@ inline double phi_pi4(double phi) noexcept {
 int main(int argc, const char* argv[]) {
   const std::array<double,2> myy_range{105e3,160e3}, myy_window{121e3,129e3};
   double data_factor = len(myy_window)/(len(myy_range)-len(myy_window));
-  double lumi = 0., lumi_in = 0., mc_factor = 1.;
+  double lumi = 0., mc_factor = 1.;
 
-  std::vector<mxaod> mxaods;
-  mxaods.reserve(argc-1);
+  mxaod_pool mxaods;
   std::string bins_file("superfine.bins"), fout_name("superfine.root");
 
   for (int a=1; a<argc; ++a) { // loop over arguments
@@ -98,10 +139,7 @@ int main(int argc, const char* argv[]) {
 
     const char *arg = argv[a], *end = arg+std::strlen(arg);
     if (std::regex_search(arg,end,match,data_re)) { // Data
-      const double flumi = std::stod(match[2]);
-      lumi_in += flumi;
       cout << "\033[36mData\033[0m: " << arg << endl;
-      cout << "\033[36mLumi\033[0m: " << flumi << " ipb" << endl;
       mxaods.emplace_back(arg,false);
     } else if (std::regex_search(arg,end,match,mc_re)) { // MC
       cout << "\033[36mMC\033[0m: " << arg << endl;
@@ -124,6 +162,8 @@ int main(int argc, const char* argv[]) {
     return 1;
   }
   cout << "\033[36mOutput file\033[0m: " << fout_name << endl;
+  // luminosities of data files are taken from the catalog
+  const double lumi_in = data_lumi(mxaods.catalog());
   cout << "\n\033[36mTotal data lumi\033[0m: "
        << lumi_in << " ipb" << endl;
   if (lumi!=0.) data_factor *= (lumi / lumi_in);
@@ -132,7 +172,7 @@ int main(int argc, const char* argv[]) {
 
   // Histogram definitions ==========================================
   re_axes ra(bins_file);
-#define h_(name) re_hist<1> h_##name(#name,ra[#name]);
+#define h_(name) mig_hist h_##name(#name,ra[#name]);
 
   h_(pT_yy) h_(yAbs_yy) h_(cosTS_yy) h_(pTt_yy) h_(Dy_y_y)
   h_(HT) h_(HT_yy)
@@ -147,40 +187,43 @@ int main(int argc, const char* argv[]) {
 
   h_(xH) h_(x1) h_(x2)
 
-  for (auto& file : mxaods) { // loop over MxAODs
+  // 2D grids, axes are looked up as NAME:x and NAME:y
+#define h2_(name) re_hist<2> h_##name(#name,ra[#name ":x"],ra[#name ":y"]);
+
+  h2_(Dphi_Dy_jj) h2_(Dphi_pi4_Dy_jj) h2_(cosTS_pT_yy) h2_(pT_yy_pT_j1)
+
+  while (mxaod file = mxaods.next()) { // loop over MxAODs
     is_mc = file.is_mc();
     cout << "\033[36m" << (is_mc ? "MC" : "Data") << "\033[0m: "
          << file->GetName() << endl;
 
     if (is_mc) { // MC
-      TIter next(file->GetListOfKeys());
-      TKey *key;
-      while ((key = static_cast<TKey*>(next()))) {
-        std::string name(key->GetName());
-        if (name.substr(0,8)!="CutFlow_" ||
-            name.substr(name.size()-18)!="_noDalitz_weighted") continue;
-        TH1 *h = static_cast<TH1*>(key->ReadObj());
-        cout << h->GetName() << endl;
-        const double n_all = h->GetBinContent(3);
-        cout << h->GetXaxis()->GetBinLabel(3) << " = " << n_all << endl;
-        mc_factor = lumi/n_all;
-        break;
-      }
+      const file_info& info = file.info();
+      cout << info.cutflow << endl;
+      cout << "sum of weights = " << info.n_all << endl;
+      mc_factor = lumi/info.n_all;
     } else { // Data
+      cout << "\033[36mLumi\033[0m: " << file.info().lumi << " ipb" << endl;
       hist_bin::weight = data_factor;
     }
 
     // read variables ===============================================
-    TTreeReader reader("CollectionTree",*file);
+    TTree *tree = nullptr;
+    file->GetObject("CollectionTree",tree);
+    if (!tree) throw ivanp::exception("no CollectionTree in ",file->GetName());
+    // only entries passing isPassed and myy_range
+    const auto elist = make_entry_list(*file,"CollectionTree",myy_range);
+    TTreeReader reader(tree,elist.get());
     optional<TTreeReaderValue<Float_t>> _cs_br_fe, _weight;
+    optional<TTreeReaderValue<Char_t>> _isFiducial;
     if (is_mc) {
       _cs_br_fe.emplace(reader,"HGamEventInfoAuxDyn.crossSectionBRfilterEff");
       _weight.emplace(reader,"HGamEventInfoAuxDyn.weight");
+      _isFiducial.emplace(reader,"HGamTruthEventInfoAuxDyn.isFiducial");
     }
-    TTreeReaderValue<Char_t> _isPassed(reader,"HGamEventInfoAuxDyn.isPassed");
 
 #define VAR_GEN_(NAME, TYPE, STR) \
-  TTreeReaderValue<TYPE> _##NAME(reader, "HGamEventInfoAuxDyn." STR);
+  var<TTreeReaderValue<TYPE>> _##NAME(reader, STR);
 #define VAR_(NAME) VAR_GEN_(NAME, Float_t, #NAME)
 #define VAR30_(NAME) VAR_GEN_(NAME, Float_t, #NAME "_30")
 
@@ -201,18 +244,14 @@ int main(int argc, const char* argv[]) {
     using tc = ivanp::timed_counter<Long64_t>;
     for (tc ent(reader.GetEntries(true)); reader.Next(); ++ent) {
 
-      // selection cut
-      if (!*_isPassed) continue;
-
-      // diphoton mass cut
+      // isPassed and myy_range cuts are applied by the entry list
       const auto m_yy = *_m_yy;
-      if (!in(m_yy,myy_range)) continue;
 
-      const bool is_in_window = in(m_yy,myy_window);
+      is_in_window = in(m_yy.det,myy_window);
 
       if (is_mc) { // signal from MC
-        if (!is_in_window) continue;
         hist_bin::weight = (**_weight) * (**_cs_br_fe) * mc_factor;
+        is_fiducial = **_isFiducial && in(m_yy.truth,myy_range);
       } else { // background from data
         if (is_in_window) continue;
       }
@@ -220,71 +259,86 @@ int main(int argc, const char* argv[]) {
       // FILL HISTOGRAMS ============================================
 
       const auto nj = *_N_j;
+      bool match_truth_nj;
 
-      const auto pT_yy = *_pT_yy*1e-3;
+      const auto pT_yy = _pT_yy*1e-3;
       const auto yAbs_yy = *_yAbs_yy;
-      const auto cosTS_yy = std::abs(*_cosTS_yy);
-      const auto Dy_y_y = std::abs(*_Dy_y_y);
+      const auto cosTS_yy = abs(*_cosTS_yy);
+      const auto Dy_y_y = abs(*_Dy_y_y);
 
-      h_pT_yy(pT_yy);
-      h_yAbs_yy(yAbs_yy);
-      h_cosTS_yy(cosTS_yy);
+      fill(h_pT_yy, pT_yy);
+      fill(h_yAbs_yy, yAbs_yy);
+      fill(h_cosTS_yy, cosTS_yy);
 
-      h_Dy_y_y(Dy_y_y);
-      h_pTt_yy(*_pTt_yy*1e-3);
+      fill(h_Dy_y_y, Dy_y_y);
+      fill(h_pTt_yy, _pTt_yy*1e-3);
+      fill(h_cosTS_pT_yy, cosTS_yy, pT_yy);
 
-      const auto HT = *_HT*1e-3;
-      h_HT(HT);
-      h_HT_yy(HT+pT_yy);
-      h_xH(pT_yy/HT);
+      const auto HT = _HT*1e-3;
+      fill(h_HT, HT);
+      fill(h_HT_yy, HT+pT_yy);
+      fill(h_xH, pT_yy/HT);
 
-      if (nj == 0) h_pT_yy_0j(pT_yy);
+      if (nj == 0) fill(h_pT_yy_0j, pT_yy, nj.truth==0);
 
       if (nj < 1) continue; // 1 jet --------------------------------
 
-      const auto pT_j1 = *_pT_j1*1e-3;
+      match_truth_nj = nj.truth>=1;
+
+      const auto pT_j1 = _pT_j1*1e-3;
 
-      h_pT_j1(pT_j1);
+      fill(h_pT_j1, pT_j1, match_truth_nj);
 
-      h_yAbs_j1(*_yAbs_j1);
+      fill(h_yAbs_j1, *_yAbs_j1, match_truth_nj);
 
-      h_sumTau_yyj(*_sumTau_yyj*1e-3);
-      h_maxTau_yyj(*_maxTau_yyj*1e-3);
+      fill(h_sumTau_yyj, _sumTau_yyj*1e-3, match_truth_nj);
+      fill(h_maxTau_yyj, _maxTau_yyj*1e-3, match_truth_nj);
 
-      h_x1(pT_j1/HT);
+      fill(h_pT_yy_pT_j1, pT_yy, pT_j1);
+
+      fill(h_x1, pT_j1/HT);
 
       if (nj == 1) {
-        h_pT_j1_excl(pT_j1);
-        h_pT_yy_1j(pT_yy);
+        match_truth_nj = nj.truth==1;
+        fill(h_pT_j1_excl, pT_j1, match_truth_nj);
+        fill(h_pT_yy_1j, pT_yy, match_truth_nj);
       }
 
       if (nj < 2) continue; // 2 jets -------------------------------
 
-      const auto pT_j2   = *_pT_j2*1e-3;
-      const auto dphi_jj = std::abs(*_Dphi_j_j);
-      const auto   dy_jj = std::abs(*_Dy_j_j);
-      const auto    m_jj = *_m_jj*1e-3;
+      match_truth_nj = nj.truth>=2;
+
+      const auto pT_j2   = _pT_j2*1e-3;
+      const auto dphi_jj = abs(*_Dphi_j_j);
+      const auto   dy_jj = abs(*_Dy_j_j);
+      const auto    m_jj = _m_jj*1e-3;
 
-      h_pT_j2(pT_j2);
-      h_yAbs_j2(*_yAbs_j2);
+      fill(h_pT_j2, pT_j2, match_truth_nj);
+      fill(h_yAbs_j2, *_yAbs_j2, match_truth_nj);
 
-      h_Dphi_yy_jj(M_PI - std::abs(*_Dphi_yy_jj));
+      fill(h_Dphi_yy_jj, _Dphi_yy_jj|[](auto x){ return M_PI - std::abs(x);},
+        match_truth_nj);
 
-      h_Dphi_j_j_signed(*_Dphi_j_j_signed);
-      h_Dphi_j_j(dphi_jj);
-      h_Dy_j_j(dy_jj);
-      h_m_jj(m_jj);
+      fill(h_Dphi_j_j_signed, *_Dphi_j_j_signed, match_truth_nj);
+      fill(h_Dphi_j_j, dphi_jj, match_truth_nj);
+      fill(h_Dy_j_j, dy_jj, match_truth_nj);
+      fill(h_m_jj, m_jj, match_truth_nj);
 
-      h_pT_yyjj(*_pT_yyjj*1e-3);
+      fill(h_pT_yyjj, _pT_yyjj*1e-3, match_truth_nj);
 
-      h_x2(pT_j2/HT);
+      fill(h_Dphi_Dy_jj, dphi_jj, dy_jj);
+      fill(h_Dphi_pi4_Dy_jj, dphi_jj|phi_pi4, dy_jj);
 
-      if (nj == 2) h_pT_yy_2j(pT_yy);
+      fill(h_x2, pT_j2/HT);
+
+      if (nj == 2) fill(h_pT_yy_2j, pT_yy, nj.truth==2);
 
       if (nj < 3) continue; // 3 jets -------------------------------
 
-      h_pT_j3(*_pT_j3*1e-3);
-      h_pT_yy_3j(pT_yy);
+      match_truth_nj = nj.truth>=3;
+
+      fill(h_pT_j3, _pT_j3*1e-3, match_truth_nj);
+      fill(h_pT_yy_3j, pT_yy, match_truth_nj);
     }
 
     file->Close();
@@ -292,15 +346,64 @@ int main(int argc, const char* argv[]) {
 
   const auto fout = std::make_unique<TFile>(fout_name.c_str(),"recreate");
 
-  for (const auto& h : re_hist<1>::all) {
-    const auto& ax = h->axis();
-    TH1D *sig = new TH1D((h.name+"_sig").c_str(),"",ax.nbins(),ax.min(),ax.max());
-    TH1D *bkg = new TH1D((h.name+"_bkg").c_str(),"",ax.nbins(),ax.min(),ax.max());
+  for (mig_hist* m : mig_hist::all) {
+    const auto& h = m->h;
+    const auto ex = edges(h.axis());
+    const int nx = ex.size()-1;
+    TH1D *sig = new TH1D((m->name+"_sig").c_str(),"",nx,ex.data());
+    TH1D *bkg = new TH1D((m->name+"_bkg").c_str(),"",nx,ex.data());
+    TH1D *reco = new TH1D((m->name+"_reco").c_str(),"",nx,ex.data());
+    sig->Sumw2();
+    bkg->Sumw2();
+
+    // sparse det x truth migration of fiducial events,
+    // one entry per filled pair of bins, ordered by det then truth
+    TTree *mig = new TTree((m->name+"_mig").c_str(),"");
+    UInt_t mig_det, mig_truth;
+    Double_t mig_w;
+    mig->Branch("det",&mig_det,"det/i");
+    mig->Branch("truth",&mig_truth,"truth/i");
+    mig->Branch("w",&mig_w,"w/D");
+
+    int i = 0;
+    for (const auto& bin : h.bins()) {
+      sig->SetBinContent(i,bin.sig);
+      sig->SetBinError(i,std::sqrt(bin.sig2));
+      bkg->SetBinContent(i,bin.bkg);
+      bkg->SetBinError(i,std::sqrt(bin.bkg2));
+      reco->SetBinContent(i,bin.reco);
+      ++i;
+    }
+
+    // rows are ordered by det, and truth within each row
+    m->mig.compress(h.nbins());
+    for (size_t r=0, nrows=m->mig.nrows(); r<nrows; ++r) {
+      mig_det = r;
+      for (auto k=m->mig.row_begin(r); k<m->mig.row_end(r); ++k) {
+        mig_truth = m->mig.col(k);
+        mig_w = m->mig.val(k);
+        mig->Fill();
+      }
+    }
+  }
 
+  for (const auto& h : re_hist<2>::all) {
+    const auto ex = edges(h->axis<0>()), ey = edges(h->axis<1>());
+    const int nx = ex.size()-1, ny = ey.size()-1;
+    TH2D *sig = new TH2D((h.name+"_sig").c_str(),"",
+      nx,ex.data(),ny,ey.data());
+    TH2D *bkg = new TH2D((h.name+"_bkg").c_str(),"",
+      nx,ex.data(),ny,ey.data());
+    sig->Sumw2();
+    bkg->Sumw2();
+
+    // binner and TH2 use the same global bin numbering
     int i = 0;
     for (const auto& bin : h->bins()) {
       sig->SetBinContent(i,bin.sig);
+      sig->SetBinError(i,std::sqrt(bin.sig2));
       bkg->SetBinContent(i,bin.bkg);
+      bkg->SetBinError(i,std::sqrt(bin.bkg2));
       ++i;
     }
   }
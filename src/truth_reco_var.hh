@@ -133,7 +133,13 @@ public:
   // operator | applies function f to both values
   template <typename F>
   inline auto operator|(F&& f) noexcept(noexcept(f(std::declval<type>())))
-  -> var<decltype(f(std::declval<type>()))> { return { det(), truth() }; }
+  -> var<decltype(f(std::declval<type>()))> {
+#ifndef VAR_ALWAYS_MC
+    return { f(det()), _truth ? f(truth()) : decltype(f(truth())){} };
+#else
+    return { f(det()), f(truth()) };
+#endif
+  }
 
 #define VAR_OP(OP) \
   template <typename U> \
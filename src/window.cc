@@ -0,0 +1,239 @@
+#include <iostream>
+#include <iomanip>
+#include <vector>
+#include <array>
+#include <string>
+#include <memory>
+#include <regex>
+#include <cmath>
+#include <cstring>
+#include <algorithm>
+
+#include <TFile.h>
+#include <TH1.h>
+#include <TH2.h>
+#include <TKey.h>
+
+#include "binner.hh"
+#include "prtbins.hh"
+#include "exception.hh"
+
+// Significance for any m_yy window from the per bin m_yy spectra
+// written by signif with the myy:N option
+
+using std::cout;
+using std::cerr;
+using std::endl;
+using ivanp::exception;
+
+struct sb_bin {
+  double bkg = 0, sig = 0, bkg2 = 0;
+};
+
+std::ostream& operator<<(std::ostream& o, const sb_bin& b) {
+  const double signif = b.sig/std::sqrt(b.sig+b.bkg);
+
+  const auto prec = o.precision();
+  const std::ios::fmtflags f( o.flags() );
+  o << std::fixed << std::setprecision(2)
+    << b.sig << ' ' // number of signal events
+    << b.bkg << ' ' // number of background events
+    << std::sqrt(b.bkg2) << ' ' // uncertainty
+    << signif << ' ' // significance
+    << (100*b.sig/(b.sig+b.bkg)) << '%' // s/(s+b)
+    << std::setprecision(prec);
+  o.flags( f );
+  return o;
+}
+
+// significance for each window of a scan, the best one highlighted
+struct scan_bin {
+  std::vector<double> signif;
+};
+
+std::ostream& operator<<(std::ostream& o, const scan_bin& b) {
+  const auto best = std::max_element(b.signif.begin(),b.signif.end());
+  const auto prec = o.precision();
+  const std::ios::fmtflags f( o.flags() );
+  o << std::fixed << std::setprecision(2);
+  for (auto it=b.signif.begin(); it!=b.signif.end(); ++it) {
+    if (it==best) o << "\033[1m" << *it << "\033[0m ";
+    else o << *it << ' ';
+  }
+  o << std::setprecision(prec);
+  o.flags( f );
+  return o;
+}
+
+using axis = ivanp::container_axis<std::vector<double>>;
+template <typename Bin>
+using hist = ivanp::binner<Bin, std::tuple<ivanp::axis_spec<axis>>>;
+
+using window = std::array<unsigned,2>; // m_yy bins [first,last)
+
+class spectra {
+  const TH2D *sig, *bkg;
+  const std::vector<char>& blinded;
+  unsigned ny;
+
+public:
+  spectra(const TH2D* sig, const TH2D* bkg, const std::vector<char>& blinded)
+  : sig(sig), bkg(bkg), blinded(blinded), ny(blinded.size()) {
+    if (sig->GetNbinsY()!=int(ny) || bkg->GetNbinsY()!=int(ny))
+      throw exception("m_yy binning of ",sig->GetName()," or ",
+        bkg->GetName()," does not match myy_blinded");
+  }
+
+  unsigned nbins() const { return sig->GetNbinsX(); }
+  axis make_axis() const {
+    const TAxis *ax = sig->GetXaxis();
+    std::vector<double> edges(nbins()+1);
+    for (unsigned i=0; i<edges.size(); ++i)
+      edges[i] = ax->GetBinLowEdge(i+1);
+    return axis(std::move(edges));
+  }
+
+  // Signal in the window, and background in the window estimated from
+  // the data in the rest of the range, less the blinded bins,
+  // scaled by the ratio of the widths
+  sb_bin operator()(int ix, const window& w) const {
+    sb_bin b;
+    double data = 0., data2 = 0.;
+    unsigned nside = 0;
+    for (unsigned j=0; j<ny; ++j) {
+      const int k = sig->GetBin(ix,j+1);
+      if (w[0] <= j && j < w[1]) b.sig += sig->GetBinContent(k);
+      else if (!blinded[j]) {
+        data += bkg->GetBinContent(k);
+        data2 += std::pow(bkg->GetBinError(k),2);
+        ++nside;
+      }
+    }
+    if (!nside) throw exception("no sidebands for the m_yy window");
+    const double f = double(w[1]-w[0])/nside;
+    b.bkg = data*f;
+    b.bkg2 = data2*f*f;
+    return b;
+  }
+};
+
+int main(int argc, const char* argv[]) {
+  const char *fin_name = nullptr;
+  std::array<double,2> win{121.,129.}; // GeV
+  std::vector<double> widths;
+
+  for (int a=1; a<argc; ++a) { // loop over arguments
+    static const std::regex root_re(
+      "^(.*/)?.*\\.root$", std::regex::optimize);
+    static const std::regex window_re(
+      "^window:([0-9.eE+-]+):([0-9.eE+-]+)$", std::regex::optimize);
+    static const std::regex scan_re(
+      "^scan:(.+)$", std::regex::optimize);
+    std::cmatch match;
+
+    const char *arg = argv[a], *end = arg+std::strlen(arg);
+    if (std::regex_search(arg,end,match,root_re)) {
+      cout << "\033[36mSpectra\033[0m: " << arg << endl;
+      fin_name = arg;
+    } else if (std::regex_search(arg,end,match,window_re)) {
+      win = { std::stod(match[1]), std::stod(match[2]) };
+    } else if (std::regex_search(arg,end,match,scan_re)) {
+      const std::string list = match[1];
+      for (size_t p=0, q; p<list.size(); p=q+1) {
+        q = list.find(',',p);
+        if (q==std::string::npos) q = list.size();
+        widths.push_back(std::stod(list.substr(p,q-p)));
+      }
+    } else {
+      cerr << "arg error: unrecognized argument: " << arg << endl;
+      return 1;
+    }
+  }
+  if (!fin_name || !(win[0] < win[1])) {
+    cerr << "usage: " << argv[0]
+         << " signif_myy.root [window:lo:hi] [scan:width,...]" << endl;
+    return 1;
+  }
+
+  auto fin = std::make_unique<TFile>(fin_name,"read");
+  if (fin->IsZombie()) return 1;
+
+  TH1D *hblinded = nullptr;
+  fin->GetObject("myy_blinded",hblinded);
+  if (!hblinded) throw exception("no myy_blinded in ",fin_name);
+  const unsigned ny = hblinded->GetNbinsX();
+  const double ylo = hblinded->GetBinLowEdge(1),
+               ydy = (hblinded->GetBinLowEdge(ny+1)-ylo)/ny;
+  std::vector<char> blinded(ny);
+  for (unsigned j=0; j<ny; ++j) blinded[j] = hblinded->GetBinContent(j+1)!=0.;
+
+  // windows snapped to m_yy bin edges
+  const auto make_window = [&](double lo, double hi){
+    window w;
+    w[0] = std::max(0l,std::lround((lo-ylo)/ydy));
+    w[1] = std::min(long(ny),std::lround((hi-ylo)/ydy));
+    if (!(w[0] < w[1])) throw exception(
+      "m_yy window [",lo,',',hi,") is outside the range");
+    return w;
+  };
+  const auto prt_window = [&](const window& w){
+    cout << '[' << ylo+w[0]*ydy << ',' << ylo+w[1]*ydy << ')';
+  };
+
+  const double center = (win[0]+win[1])/2;
+  std::vector<window> windows;
+  if (widths.empty()) {
+    windows.push_back(make_window(win[0],win[1]));
+    cout << "\033[36mWindow\033[0m: ";
+    prt_window(windows.front());
+  } else {
+    cout << "\033[36mWindows\033[0m:";
+    for (const double w : widths) {
+      windows.push_back(make_window(center-w/2,center+w/2));
+      cout << ' ';
+      prt_window(windows.back());
+    }
+  }
+  cout << " GeV\n" << endl;
+
+  // loop over variables ============================================
+  std::vector<std::unique_ptr<hist<sb_bin>>> hists;
+  std::vector<std::unique_ptr<hist<scan_bin>>> scans;
+  TIter next(fin->GetListOfKeys());
+  TKey *key;
+  while ((key = static_cast<TKey*>(next()))) {
+    const std::string name(key->GetName());
+    static const std::string suffix("_sig_myy");
+    if (name.size() <= suffix.size() ||
+        name.compare(name.size()-suffix.size(),suffix.size(),suffix))
+      continue;
+    const std::string var = name.substr(0,name.size()-suffix.size());
+
+    TH2D *hsig = nullptr, *hbkg = nullptr;
+    fin->GetObject(name.c_str(),hsig);
+    fin->GetObject((var+"_bkg_myy").c_str(),hbkg);
+    if (!hsig || !hbkg)
+      throw exception("missing m_yy spectra for variable \'",var,"\'");
+    const spectra sp(hsig,hbkg,blinded);
+
+    if (widths.empty()) {
+      hists.emplace_back(new hist<sb_bin>(var,sp.make_axis()));
+      auto& bins = hists.back()->bins();
+      for (unsigned i=0; i<bins.size(); ++i)
+        bins[i] = sp(i,windows.front());
+    } else {
+      scans.emplace_back(new hist<scan_bin>(var,sp.make_axis()));
+      auto& bins = scans.back()->bins();
+      for (unsigned i=0; i<bins.size(); ++i)
+        for (const auto& w : windows) {
+          const sb_bin b = sp(i,w);
+          bins[i].signif.push_back(b.sig/std::sqrt(b.sig+b.bkg));
+        }
+    }
+  }
+
+  for (const auto& h : hist<sb_bin>::all) cout << h << endl;
+  for (const auto& h : hist<scan_bin>::all) cout << h << endl;
+
+  return 0;
+}